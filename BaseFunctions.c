@@ -1,21 +1,25 @@
 /*----------------------------------------------------------------------------*
 CHECK ALL EVENTS
 
-This routine find the ealiest event for individual n and schedules it.
+This routine find the ealiest event for individual n and schedules it. If an
+event is already scheduled for the individual it is rescheduled in place.
 
 */
-#define SCHED(X, Y, Z)   \
-  {                      \
-    A[n].pending = X;    \
-    EventSchedule(n, Y); \
-    return Z;            \
+#define SCHED(X, Y, Z)     \
+  {                        \
+    Af(n, pending) = X;    \
+    EventReschedule(n, Y); \
+    return Z;              \
   }
 Check_all_events(int n)
 {
   int i;
-  i = Earliest(A[n].t);
-  SCHED(i, A[n].t[i], i); //Schedule the earliest event.
-  return 1;               //(Will never reach this.)
+  dec w[MaxT + 1];
+  for (i = 0; i <= MaxT; i++) //Gather the individual's times
+    w[i] = At(n, t[i]);       //in years, whatever their layout
+  i = Earliest(w);            //('SOA') or encoding ('TIME32').
+  SCHED(i, w[i], i); //Schedule the earliest event.
+  return 1;          //(Will never reach this.)
 }
 
 /*----------------------------------------------------------------------------*
@@ -25,10 +29,10 @@ This routing initializes binding lists in A
 */
 InitAbinds(int n)
 {
-  A[n].bto[0] = 0;
-  A[n].bto[1] = 0;
-  A[n].bfrom[0] = 0;
-  A[n].bfrom[1] = 0;
+  Af(n, bto)[0] = 0;
+  Af(n, bto)[1] = 0;
+  Af(n, bfrom)[0] = 0;
+  Af(n, bfrom)[1] = 0;
   return 1;
 }
 /*----------------------------------------------------------------------------*
@@ -46,9 +50,9 @@ Find_individual(id)
   int i;
   for (i = 0; i < indiv + 1; i++)
   {
-    if (A[i].id == id)
+    if (Af(i, id) == id)
     {
-      A[i].InFunction = fnc_Find_individual;
+      Af(i, InFunction) = fnc_Find_individual;
       return i;
     }
   }
@@ -56,67 +60,26 @@ Find_individual(id)
 /*----------------------------------------------------------------------------*
 TRANSFER GROUP
 
-This routine transfer and individual and all their information (including saved event
-times) to a group. The routine then cancels the pending
-event for that index number and re-schedules it using the new index number.
+This routine moves an individual to another group, with 'CCgo'. The record and
+its pending event keep their index number, 'n'.
 
 ENTRY: 'grp' is the new group to be assigned
-       'n' is the current index number of the individual.
+       'n' is the index number of the individual.
 
-EXIT:  'm' is the new index number of the individual.
-       'grp' in the new group fro the individual.
-       individual n id deleted
-       The old and new group counters are updated
-       The funtion returns the new index of the individual
+EXIT:  'A[n].groupID' is 'grp'.
+       The counts by group and state have moved with it ('CCgo').
+       The funtion returns zero if the individual could not be moved.
 */
 
 TransferGroup(int n, int grp)
 { //printf("Starting TransferGroup()...\n"); fflush(stdout);
-  A[n].InFunction = fnc_TransferGroup;
-  int m, yr, st, gid, q;
-  gid = A[n].groupID;
-  st = A[n].strain;
-  yr = (int)t - (int)t0;
-  q = A[n].state;
-  N[gid] -= 1;
-  m = CCadd(grp); //create a new individual in the settle immigrant group
-  InitAbinds(m);
-  Check_all_events(n);    //update events
-  Transfer(m, n);         //Transfer individual and all information
-                          //from the recent migrant to settle migrant group
-  A[m].groupID = grp;     //Update the group ID
-  CCdel(A[n].groupID, n); //Remove duplicate individual from old group
-  N[A[m].groupID] += 1;
-  return m;
-}
-
-/*----------------------------------------------------------------------------*
-TRANSFER
-
-This routine transfer all information about an individual (including saved event
-times) to a new identification number. The routine then cancels the pending
-event for that index number and re-schedules it using the new index number.
-
-ENTRY: 'n' is the new index number to be assigned, which has no event scheduled
-       'n0' is the current index number of the individual.
-       There is an event scheduled for 'n0'.
-
-EXIT:  'n' is the new index number of the individual.
-       The event scheduled for n0 is now re-scheduled under 'n' and all other
-         data from 'n0' are transferred to 'n'. 'n0' no longer has an event
-         scheduled and the index number is free to be used again.
-*/
-
-Transfer(int n, int n0)
-{ //printf("Starting Transfer()...\n"); fflush(stdout);
-  A[n].InFunction = fnc_Transfer;
-  if (n != n0)
-  {
-    DetachH(n0);
-    A[n] = A[n0];
-    AttachH(n);
-    EventRenumber(n, n0); //Copy data and reschedule as 'n'.
-  }
+  Af(n, InFunction) = fnc_TransferGroup;
+  int gid;
+  gid = Af(n, groupID);
+  if (CCgo(gid, n, grp) == 0) //Move the individual to the new group.
+    return 0;
+  Af(n, groupID) = grp; //Update the group ID
+  return 1;
 }
 /*----------------------------------------------------------------------------*
 INITIALIZE Groups
@@ -150,4 +113,71 @@ GroupInit()
   }
   Emptyc[nC] = 0.; //close the lost of groups
   Clowest[nC] = mA2 + 1;
+  CChandleInit(); //provide the handles
+  CCweightInit(); //and weighted selection
+}
+
+/*----------------------------------------------------------------------------*
+ALLOCATE INDIVIDUALS
+
+'AllocIndiv' provides the list of individuals 'A', in the layout selected by
+'SOA' (see 'common.h'), with every field zero, and 'FreeIndiv' releases it.
+
+ENTRY: 'm' contains the number of records required ('AllocIndiv').
+
+EXIT:  'A' contains 'm' records.
+       'AllocIndiv' contains the number of bytes allocated.
+*/
+
+#define COL(f) (b += (dec)m * sizeof *A->f, (A->f = calloc(m, sizeof *A->f)) == 0)
+
+dec AllocIndiv(int m)
+{
+  dec b;
+#if SOA
+  static struct Indiv Ac; //Addresses of the columns.
+  int i;
+
+  A = &Ac;
+  b = 0;
+  for (i = 0; i <= MaxT; i++) //Provide each column,
+    if (COL(t[i]))            //counting the bytes.
+      Error(911.);
+  if (COL(pending) || COL(state) || COL(groupID) || COL(v) || COL(id) ||
+      COL(idn) || COL(sex) || COL(rob) || COL(strain) || COL(InFunction) ||
+      COL(bto) || COL(bfrom))
+    Error(911.);
+#else
+  A = (struct Indiv *)calloc(m, sizeof(struct Indiv)); //(Not static because of
+  if (A == 0)                                          //gcc bug restricting
+    Error(911.);                                       //such arrays to 2GB.)
+  b = (dec)m * sizeof(struct Indiv);
+#endif
+  return b;
+}
+
+FreeIndiv()
+{
+#if SOA
+  int i;
+
+  for (i = 0; i <= MaxT; i++)
+    free(A->t[i]);
+  free(A->pending);
+  free(A->state);
+  free(A->groupID);
+  free(A->v);
+  free(A->id);
+  free(A->idn);
+  free(A->sex);
+  free(A->rob);
+  free(A->strain);
+  free(A->InFunction);
+  free(A->bto);
+  free(A->bfrom);
+#else
+  free(A);
+#endif
+  A = 0;
+  return 1;
 }
@@ -2,8 +2,8 @@ int prnt = 0; //on and off switch fro printing output
 
 struct Indiv *A; //State of each individual, including their
                  //characterisitics, saved event times, etc.
+dec Abytes;      //Memory they occupy ('AllocIndiv').
 //Initialize time
-#define T0 1981         //Start time of model, years.
 #define T1 2050         //End time of model, years. The simulation \
                         //ends -before- reaching this year.
 dec interv = T1 - 500.; //Time of intervention start
@@ -18,7 +18,6 @@ int Target_pop_size = 700000; //Population size if population size will be const
                  //parameters (4 in this version), 0=no, 1=yes.
 #define REC 1    //Flag for whether tallying recent transmissions.
 //Psuedo individuals
-#define BIRTH (indiv + 1) //Index used for scheduling births.
 #define nEngines 1
 //Groups
 #define NUK 0         //Array index for non-UK born.
@@ -38,11 +37,7 @@ int Target_pop_size = 700000; //Population size if population size will be const
 #define maxBY 2010
 #define minBY 1870
 //Counters
-int N[TotalPgrps];             //Current number in each group
-int UTB[TotalPgrps];           //Current number uninfected in each group
-int LTB[TotalPgrps];           //Current number with latent TB in each group
-int ATB[TotalPgrps];           //Current number with active TB in each group
-int DTB[TotalPgrps];           //Current number with dormant TB in each group
+int Nmid[TotalPgrps][q1 + 1];  //Mid-year number in each group and state
 dec age1[2], age2[2], agec[2]; //Accumulators for 1st and 2nd moments of age.
 
 int deaths;       //Current number of deaths.
@@ -107,6 +102,9 @@ dec randseq = 0;      //Random number sequence (set with 'randseq=N').
 dec tgap = 1;         //0.5;             //Time between reports, years.
 dec kernel = 0;       //Contagion kernel, 0=Panmictic, 1=Cauchy.
 dec sigma = 1;        //Width of contagion kernel, where applicable.
+dec scheduler = -1;   //Event scheduler backend (set with 'scheduler=N'), or -1 for the compiled default.
+dec telemetry = 0;    //Set to write scheduler counters at each report (set with 'telemetry=1').
+dec trace = 0;        //Set to record the event stream for 'replay.c' (set with 'trace=1').
 
 //create an output file to store simulation results
 char fnamestem[] = "summary";
@@ -114,6 +112,10 @@ dec fnumber = 12.;
 char fname[BUFSIZ];
 FILE *fptr, *fpds;
 char ftimesname[] = "diseasetocare.txt";
+char ftelname[BUFSIZ]; //Scheduler telemetry, when 'telemetry' is set.
+FILE *fptel;
+char ftracename[BUFSIZ]; //Event trace, when 'trace' is set.
+FILE *fptrace;
 
 struct IO fmt[] = //Format statements for input/output.
     {
@@ -196,6 +198,7 @@ MainInit()
   int i, j, k, l, m, n, dt, route, st;
   //Initialize counters
   for (j = 0; j < TotalPgrps; j++) //Groups
-    N[j] = 0;
+    for (k = q0; k <= q1; k++)     //and states
+      Nmid[j][k] = 0;
   popsize = 0; //current population size
 }
@@ -9,7 +9,7 @@ ENTRY: 'n' indexes an individual who has just progressed.
 
 EXIT:
        'progressions' is incremented.
-       Counters in 'A','L' are updated.
+       The individual is counted as active in its group.
        Counters 'age1', 'age2', and 'agec' are updated.???
        death from TB or dormancy is scheduled for individual n
 
@@ -19,28 +19,26 @@ Progress(int n)
 {
   int n2, yr, gid, tr, st, q, qv;
   dec age, mort, wd;
-  A[n].InFunction = fnc_Progress;
-  st = A[n].strain;
+  Af(n, InFunction) = fnc_Progress;
+  st = Af(n, strain);
 
-  gid = A[n].groupID;    // individual's current group ID
-  A[n].state = qATB;     // update current infection state
-  age = t - A[n].tBirth; //Compute the age at progression.
-  s = A[n].sex;
+  gid = Af(n, groupID);    // individual's current group ID
+  CCstate(gid, n, qATB);   // update current infection state
+  age = t - At(n, tBirth); //Compute the age at progression.
+  s = Af(n, sex);
   mort = 2.0;
 
   progressions += 1; //Increment the number of progressions.
-  LTB[gid] -= 1;     //Decrement the number of Latent
-  ATB[gid] += 1;     //Increment the number of Actives
 
   EventCancel(n); //cancel this event
 
   te = Expon(mort); //
   wd = t + te;
-  if (wd < A[n].tDeath)
+  if (wd < At(n, tDeath))
   {
 
-    A[n].tDeath = wd;      // update time of death
-    A[n].pending = pDeath; // update pending event
+    Aset(n, tDeath, wd);     // update time of death
+    Af(n, pending) = pDeath; // update pending event
     EventSchedule(n, wd);
   }
   return 1;
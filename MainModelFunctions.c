@@ -26,10 +26,7 @@ int mainfx(int argc, char *argv[])
   //FinalInit();                               //Start the final reports.
   ReportInit(); //Start the output reports.
 
-  A = (struct Indiv *)                                          //Allocate array of individuals. struct Indiv defined in common.h
-      calloc(indiv + NPSEUDO, sizeof(struct Indiv) + nEngines); //(Not static because of gcc bug
-  if (A == 0)
-    Error(911.); //restricting such arrays to 2GB.)
+  Abytes = AllocIndiv(indiv + NPSEUDO); //Allocate array of individuals. struct Indiv defined in common.h
 
   if (SUPER)
     maximm = 10000000; //Adjust 'maximm' depending on
@@ -43,6 +40,9 @@ int mainfx(int argc, char *argv[])
   gparam(argc, argv); //Collect parameters for this run
                       //which have been specified on
                       //command line.
+  if (scheduler >= 0)
+    EventBackend((int)scheduler); //Select the event scheduler
+  EventCapacity(CLOCK0 + CLOCKS); //and provide for every index.
 
   Param(); //Update variables/distributions
            //affected by parameters which
@@ -67,6 +67,15 @@ int mainfx(int argc, char *argv[])
   else
     rand0 = RandStartArb(rand0); //place.
 
+  if (trace) //Record the event stream if
+  {          //requested.
+    snprintf(ftracename, sizeof(ftracename), "%s_%d%d_trace.bin", fnamestem, (int)fnumber, (int)randseq);
+    fptrace = fopen(ftracename, "wb");
+    if (fptrace == 0)
+      Error(912.1);
+    EventTrace(fptrace);
+  }
+
   EventStartTime(t0); //Initialize the event queues.
 
   t = t0; //Set the starting time
@@ -80,23 +89,35 @@ int mainfx(int argc, char *argv[])
   printf("\n");
   printf("  The name is %d.\n", (int)fnumber);
   fptr = fopen(fname, "w");
+  if (telemetry)
+  {
+    snprintf(ftelname, sizeof(ftelname), "%s_%d%d_sched.txt", fnamestem, (int)fnumber, (int)randseq);
+    fptel = fopen(ftelname, "w");
+    if (fptel == 0)
+      Error(912.); //Open the scheduler telemetry file.
+  }
   Report(argv[0]);
   pt = t; //Report initial conditions.
 
-  BirthG();                        //Start external event generators
-  for (t = t0; t < t1; Dispatch()) //Main loop: process events,
-  {
-    if (t - pt < tgap)
-      continue; //reporting results periodically.
-    pt = t;
-    Report(argv[0]);
-  }
+  BirthStart();          //Start external event generators
+  ObserveStart(argv[0]); //and periodic observers.
+  DispatchTo(t1);        //Main loop: process all events.
 
+  t = t1;
   Report(argv[0]); //Get final report.
+  if (telemetry)
+    CCprofile("Final"); //Display the work of the groups.
   fclose(fptr);
   fclose(fpds);
+  if (telemetry)
+    fclose(fptel);
+  if (trace)
+  {
+    EventTrace(0);
+    fclose(fptrace);
+  }
 
-  free(A); //caller.
+  FreeIndiv(); //caller.
 
   return 0;
 }
@@ -104,9 +125,9 @@ int mainfx(int argc, char *argv[])
 /*----------------------------------------------------------------------------*
 DISPATCH NEXT EVENT
 
-All events pass through this routine. It picks the earliest event in the
-queue, sets the time to match that event, and performs the operations called
-for by that event. Typically that will result in other events being scheduled,
+This routine dispatches a single event; the main loop dispatches them in runs
+with 'DispatchTo'. It picks the earliest event in the queue, sets the time to
+match that event, and performs the operations called for by that event. Typically that will result in other events being scheduled,
 to be seen in the future as they arrive at the front of the queue.
 
 ENTRY: The system is initialized with all events in the list ready for
@@ -128,10 +149,82 @@ Dispatch()
   tw = t; //Remember the previous time.
   n = EventNext();
   if (t > t1)
-    return 0;   //Advance time to the next event. //Tendai changed return to return 0; to avoid warnings
+    return 0; //Advance time to the next event. //Tendai changed return to return 0; to avoid warnings
+  Process(n, tw);
+}
+
+/*----------------------------------------------------------------------------*
+DISPATCH EVENTS UP TO A HORIZON
+
+This routine dispatches events in runs, as long as each is earlier than the
+horizon, so that the main loop need not check the time after every event.
+Reports and other periodic work are themselves events, driven by clocks (see
+'ObserveStart'). Events are taken ahead from the scheduler 'EB' at a time,
+and the record of the individual 'PF' events ahead is fetched into cache while
+earlier events are processed. Events are processed one at a time in the order
+of their times, exactly as by 'Dispatch', since each may schedule, cancel, or
+reschedule others.
+
+ENTRY: 'tr' contains the horizon, not later than 't1'.
+
+EXIT:  'DispatchTo' contains the number of events processed. Zero means the
+         next event is not earlier than 'tr'.
+       't' contains the time of the last event processed.
+*/
+
+#define EB 64 //Events taken ahead at a time,
+#define PF 8  //and how far ahead to prefetch.
+
+#ifdef __GNUC__
+#define PREFETCH(p) __builtin_prefetch(p)
+#else
+#define PREFETCH(p)
+#endif
+
+int DispatchTo(dec tr)
+{
+  int i, k, n, m, c;
+  dec tw;
+
+  for (c = 0; (k = EventNextBatch(tr, EB)) > 0;) //Take events ahead.
+    for (i = 0; i < k; i++)
+    {
+      m = EventAhead(PF);                 //Fetch a later individual's
+      if (m > 0 && m < CLOCK0)            //record, if any (clocks have
+        PREFETCH(&Af(m, pending));        //none), and process the next
+      tw = t;                             //event if it is still before
+      if ((n = EventNextBefore(tr)) == 0) //the horizon.
+        return c;
+      Process(n, tw);
+      c += 1;
+    }
+  return c;
+}
+
+/*----------------------------------------------------------------------------*
+PROCESS ONE EVENT
+
+ENTRY: 'n' contains the number of the event just dispatched.
+       't' contains its time.
+       'tw' contains the time of the previous event.
+
+EXIT:  The event has been processed and 'events' incremented.
+*/
+
+int Process(int n, dec tw)
+{
   tstep(tw, t); //Record the size of the time step.
   events += 1;  //Increment the events counter.
-  switch (A[n].pending)
+  if (n >= CLOCK0) //Tick a clock,
+  {
+    if (trace)
+      EventTraceNote(n, pClock, n - CLOCK0);
+    ClockFire(n);
+    return 0;
+  }
+  if (trace) //or process an individual's event.
+    EventTraceNote(n, Af(n, pending), Af(n, id));
+  switch (Af(n, pending))
   { //Process the event.
   case pDeath:
     Death(n);
@@ -145,20 +238,19 @@ Dispatch()
   case pDeathTB:
     DeathTB(n);
     break;
-  case pBirth:
-    BirthG();
-    break; //[birth generator]
   default:
     Error2(921.2, //[system error]
-           "`A[", n, "].pending=", A[n].pending);
+           "`A[", n, "].pending=", Af(n, pending));
   }
 }
 
 /*----------------------------------------------------------------------------*
 BIRTH GENERATOR
 
-This routine initiates a birth and schedules the next birth, at regularly spaced
-intervals, acting as the peripheral event generator for births.
+This routine initiates a birth. It is called at each tick of the birth clock,
+which the scheduler runs at regularly spaced intervals, acting as the
+peripheral event generator for births. 'BirthStart' sets up the clock and
+starts it with a birth at the present time.
 
 ENTRY: 't' contains the current time.
        'ypb' is the number of years per birth. That is, the reciprocal of the
@@ -168,26 +260,28 @@ ENTRY: 't' contains the current time.
          and 't+ypb'. 'rel' is between zero and one.
 
 EXIT:  A new individual has been born and added to the UK group.
-       The next birth has been scheduled.
+       (BirthStart) The next birth has been scheduled.
 */
 struct Clock Cbirth; //Create a new clock structure
-BirthG()
+BirthStart()
 {
-  int yr, n;
-  yr = (int)(t - t0);
-  n = CCadd(UK);
-  Birth(n, t);           //Create someone born in the UK.
   Cbirth.type = 4;       //Assign clock type
   Cbirth.rate = 1 / ypb; //Assign birth rate
   //Cbirth.rate=1/ypb_fixed;           //if rate is fixed
   //Cbirth.rate=bcy[yr];  		//if rate in based on data sotred in array bcy
 
-  Cbirth.rel = 1;             //Assign relative width of a random
-                              //interval during which the next
-                              //birth is allowed to happen.
-  Cbirth = ClockTick(Cbirth); //call clock ticker
-  A[BIRTH].pending = pBirth;  //Schedule the next birth.
-  EventSchedule(BIRTH, Cbirth.next);
+  Cbirth.rel = 1; //Assign relative width of a random
+                  //interval during which the next
+                  //birth is allowed to happen.
+  BirthG();                    //Give the first birth and have the
+  ClockStart(&Cbirth, BirthG); //scheduler give the rest.
+}
+
+BirthG()
+{
+  int n;
+  n = CCadd(UK);
+  Birth(n, t); //Create someone born in the UK.
 }
 
 /*----------------------------------------------------------------------------*
@@ -213,17 +307,17 @@ EXIT:  'Birth' contains a status code.
          1 Entry 'n' is initialized as a susceptible newborn and its first event
             is scheduled, either emigration or death.
        'A[n].state' marks a susceptible individual.
-       Counters in 'N' are updated.
+       The counts by group and state are updated.
 */
 
 int Birth(int n, dec b)
 {
   int y, s, v, e, rob, st;
   dec wd, wh, we, age;
-  A[n].InFunction = fnc_Birth;
+  Af(n, InFunction) = fnc_Birth;
 
   y = (int)t - (int)t0; //Retrieve year index for arrays.
-  if (n < Clowest[UK])
+  if (Gs[n] < Clowest[UK])
     Error1(610.1, "n=", (dec)n); //Check for appropriate 'n', this
   if (n > indiv)
     Error1(610.2, "n=", (dec)n); //routine does not allow immigrant
@@ -231,15 +325,14 @@ int Birth(int n, dec b)
                                  //index number >'indiv'.
   nbirths += 1;
   //A[n].sex = Rand()<pmale[y]? 0: 1;          //Assign the newborn's sex from data array.
-  A[n].sex = Rand() < 0.5 ? 0 : 1; //Assign the newborn's sex from random number generation.
-  s = A[n].sex;
+  Af(n, sex) = Rand() < 0.5 ? 0 : 1; //Assign the newborn's sex from random number generation.
+  s = Af(n, sex);
   age = 0.;                      //sent age
   rob = UK;                      //assign country of birth
   st = Rand() < 0.00078 ? 1 : 0; //Assign infection status from random number generation.
 
   BasicInd(y, n, UK, age, s, UK, st); //Set up basic individual.
-  EventCancel(n);
-  Check_all_events(n); //Update schedule for all events
+  Check_all_events(n);                //Update schedule for all events
 }
 
 /*----------------------------------------------------------------------------*
@@ -260,21 +353,20 @@ EXIT:  Either entry 'n' is sent to the Birth() function, to be initialized as a
        function returns '1'.
        'deaths' is incremented.
        Counters 'age1', 'age2', and 'agec' are updated.
-       Counters in 'N',popsize are updated.
+       The counts by group and state are updated by 'CCdel'.
 */
 
 #define DTYPE 0 //Allows for non-constant population \
                 //size.
 Death(int n)
 {
-  int n2, yr, gid, tr, st, q, qv;
+  int n2, yr, gid, tr, st, qv;
   dec age;
-  A[n].InFunction = fnc_Death;
-  st = A[n].strain;
-  yr = (int)(t - t0);    //current year
-  age = t - A[n].tBirth; //Compute the age at death.
-  gid = A[n].groupID;    // individual's current group ID
-  q = A[n].state;        // individual's current infection state
+  Af(n, InFunction) = fnc_Death;
+  st = Af(n, strain);
+  yr = (int)(t - t0);      //current year
+  age = t - At(n, tBirth); //Compute the age at death.
+  gid = Af(n, groupID);    // individual's current group ID
 
   {
     age1[0] += age;
@@ -282,30 +374,13 @@ Death(int n)
     agec[0] += 1;
   } //age and its variance.
 
-  N[gid] -= 1;  //Decrement N[A[n].groupID][A[n].state].
-  popsize -= 1; //updte population size
-  deaths += 1;  //Increment the number of deaths.
-  if (q == qUTB)
-  {
-    uninfecteds -= 1;
-    UTB[gid] -= 1;
-  }
-  else if (q == qLTB)
-  {
-    latents -= 1;
-    LTB[gid] -= 1;
-  }
-  else if (q == qATB)
-  {
-    actives -= 1;
-    ATB[gid] -= 1;
-  }
+  deaths += 1; //Increment the number of deaths.
 
-  BindDelete(A[n].bfrom); //remove contact links
-  BindDelete(A[n].bto);   //remove contact links
-  DetachH(n);             //Remove from the database.
-  CCdel(gid, n);          //remove individual
-  if (DTYPE == 0)         //If population size is to be held
+  BindDelete(Af(n, bfrom)); //remove contact links
+  BindDelete(Af(n, bto));   //remove contact links
+  DetachH(n);               //Remove from the database.
+  CCdel(gid, n);            //remove individual
+  if (DTYPE == 0)           //If population size is to be held
   {
     n = CCadd(UK);
     Birth(n, t); //constant, initiate a birth.
@@ -326,7 +401,7 @@ ENTRY: 'n' indexes an individual who has just progressed.
 
 EXIT:
        'progressions' is incremented.
-       Counters in 'A','L' are updated.
+       The individual is counted as active in its group.
        death from TB or dormancy is scheduled for individual n
 
 */
@@ -334,25 +409,21 @@ Progress(int n)
 {
   int n2, yr, gid, tr, st, q, qv, s;
   dec age, mort, wd, rreg, wr;
-  A[n].tProgress = 0;
-  A[n].InFunction = fnc_Progress;
-  st = A[n].strain;
-
-  gid = A[n].groupID;    // individual's current group ID
-  A[n].state = qATB;     // update current infection state
-  age = t - A[n].tBirth; //Compute the age at progression.
-  s = A[n].sex;
+  Aset(n, tProgress, 0);
+  Af(n, InFunction) = fnc_Progress;
+  st = Af(n, strain);
+
+  gid = Af(n, groupID);    // individual's current group ID
+  CCstate(gid, n, qATB);   // update current infection state
+  age = t - At(n, tBirth); //Compute the age at progression.
+  s = Af(n, sex);
   mort = 0.1; // annual rate of death from disease
   rreg = 0.2; // annual rate of remission
 
   progressions += 1; //Increment the number of progressions.
-  LTB[gid] -= 1;     //Decrement the number of Latent
-  ATB[gid] += 1;     //Increment the number of Actives
-  actives += 1;
-  latents -= 1;
 
-  A[n].tDeathTB = t + Expon(mort); // calculate calendar date til death from disease
-  A[n].tRegress = t + Expon(rreg); //calc calendar date of remission
+  Aset(n, tDeathTB, t + Expon(mort)); // calculate calendar date til death from disease
+  Aset(n, tRegress, t + Expon(rreg)); //calc calendar date of remission
 
   Check_all_events(n); //Update schedule for all events
 
@@ -370,7 +441,7 @@ ENTRY: 'n' indexes an individual who has just become dormant.
 
 EXIT:
        'dormancies' is incremented.
-       Counters in 'A','D' are updated.
+       The individual is counted as dormant in its group.
        death from natural causes is scheduled for individual n
 
 */
@@ -378,21 +449,17 @@ Regress(int n)
 {
   int gid, st, q, s;
   dec age, mort, wd, te;
-  A[n].tRegress = 0;
-  A[n].InFunction = fnc_Regress;
+  Aset(n, tRegress, 0);
+  Af(n, InFunction) = fnc_Regress;
 
-  gid = A[n].groupID;    // individual's current group ID
-  A[n].state = qDTB;     // update current infection state
-  age = t - A[n].tBirth; //Compute the age at progression.
-  s = A[n].sex;
+  gid = Af(n, groupID);    // individual's current group ID
+  CCstate(gid, n, qDTB);   // update current infection state
+  age = t - At(n, tBirth); //Compute the age at progression.
+  s = Af(n, sex);
 
   regressions += 1; //Increment the number of dormancies.
-  ATB[gid] -= 1;    //Decrement the number of Actives
-  DTB[gid] += 1;    //Increment the number of Dormants
-  actives -= 1;     //Decrement the number of Actives
-  dormants += 1;    //Increment the number of Dormants
 
-  A[n].tDeathTB = 0;
+  Aset(n, tDeathTB, 0);
 
   Check_all_events(n); //Update schedule for all events
 
@@ -402,25 +469,20 @@ Regress(int n)
 DeathTB(int n)
 {
   int gid, age;
-  A[n].tDeathTB = 0;
-  A[n].InFunction = fnc_DeathTB;
-  gid = A[n].groupID;    // individual's current group ID
-  age = t - A[n].tBirth; //Compute the age at progression.
+  Aset(n, tDeathTB, 0);
+  Af(n, InFunction) = fnc_DeathTB;
+  gid = Af(n, groupID);    // individual's current group ID
+  age = t - At(n, tBirth); //Compute the age at progression.
   age1[1] += age;
   age2[1] += age * age; //Accumulate statistics for mean
   agec[1] += 1;         //age and its variance.
-  N[gid] -= 1;          //Decrement N[A[n].groupID][A[n].state].
-  popsize -= 1;         //updte population size
   deathsTB += 1;        //Increment the number of deaths.
 
-  actives -= 1;
-  ATB[gid] -= 1;
-
-  BindDelete(A[n].bfrom); //remove contact links
-  BindDelete(A[n].bto);   //remove contact links
-  DetachH(n);             //Remove from the database.
-  CCdel(gid, n);          //remove individual
-  if (DTYPE == 0)         //If population size is to be held
+  BindDelete(Af(n, bfrom)); //remove contact links
+  BindDelete(Af(n, bto));   //remove contact links
+  DetachH(n);               //Remove from the database.
+  CCdel(gid, n);            //remove individual
+  if (DTYPE == 0)           //If population size is to be held
   {
     n = CCadd(UK);
     Birth(n, t); //constant, initiate a birth.
@@ -441,12 +503,12 @@ EXIT:  If the population is < Target_pop_size: a new
 	is selected and sent to the Death() function, to be removed from the population.
        'deaths' is incremented.
        Counters 'age1', 'age2', and 'agec' are updated.
-       Counters in 'N',popsize are updated.
 */
+#define CB 256 //Individuals culled in each block.
 Check_population_size()
 {
-  int y, j, n, i, z;
-  int grpcount, randgrp;
+  int y, j, n, i, z, c, g;
+  int m[2], x[CB];
 
   z = CCgroup_size(NUK) + CCgroup_size(UK); //Current populaton size
 
@@ -459,22 +521,20 @@ Check_population_size()
     }
   } //Create someone born in the UK.
 
-  if (z > Target_pop_size)
-  { //check if current population is too large
-    if ((z - Target_pop_size) > 0)
-    { //select (z-Target_pop_size) to repmove from the population
-      j = 0;
-      do
+  for (c = z - Target_pop_size; c > 0; c -= j) //If the population is too large,
+  {                                            //remove the excess in blocks.
+    j = min(c, CB);
+    m[0] = m[1] = 0;
+    for (i = 0; i < j; i++)    //Divide the block between the two
+      m[(int)(Rand() * 2)] += 1; //groups at random and select from
+    for (g = 0; g < 2; g++)      //each without replacement.
+    {
+      y = CCselMany(g, m[g], x, 0);
+      for (i = 0; i < y; i++) //Remove them via death.
       {
-        do
-        {
-          randgrp = Rand() * 2;
-          n = CCsel(randgrp);
-        } while (n == 0); //select a random indiv from the whole population
-        EventCancel(n);
-        Death(n); //remove the individual via death
-        j++;
-      } while (j < (z - Target_pop_size));
+        EventCancel(x[i]);
+        Death(x[i]);
+      }
     }
   }
 }
@@ -509,8 +569,8 @@ dec LifeDsn(int n, int sex, dec age, dec mort)
 {
   int yb, y, gid, q;
   dec w;
-  gid = A[n].groupID;
-  q = A[n].state;
+  gid = Af(n, groupID);
+  q = Af(n, state);
   switch (lifedsn)
   {
   case 0:
@@ -565,6 +625,7 @@ InitPop()
   GroupInit(); //Initialize groups
   ii = 0;
   yr = (int)(t - t0);
+  EventBatchBegin(); //Load all initial events at once.
 
   for (a = 0; a < 121; a++)
   { //age
@@ -582,12 +643,12 @@ InitPop()
 
           ii = ii + 1;
           BasicInd(yr, n, rob, age, s, rob, st); //Set up basic individual.
-          EventCancel(n);
           Check_all_events(n);
         }
       }
     }
   }
+  EventBatchCommit();
 }
 /*----------------------------------------------------------------------------*
 SET UP BASIC INDIVIDUAL FOR POPULATION INITIALIZATION
@@ -604,49 +665,42 @@ ENTRY:  'A[n]' individual is not scheduled for any event.
         'age' is the age of the individual in years.
         'sex' is 0 for males and 1 for females.
 
-EXIT:   'A[n]' is in the Uninfected state and scheduled for its earliest
-          event.
+EXIT:   'A[n]' is in state 'st', counted in group 'grp' with weight 1, and
+          scheduled for its earliest event.
 
 */
 BasicInd(int yr, int n, int rob, dec age, int s, int grp, int st)
 {
   dec wd, we, wv, prog;
   int q;
-  A[n].InFunction = fnc_BasicInd;
-  popsize += 1;          //update population size
-  A[n].id = IDnew();     //Assign unique ID number
-  AttachH(n);            //Attach to database
-  InitAbinds(n);         //initialize contact bindinds
-  clear_times(n);        //Initialize times
-  A[n].v = 1;            //Maximum probability to be chosen: Tendai
-  A[n].rob = rob;        //Set to rob
-  A[n].groupID = grp;    //Assign initial group
-  A[n].tBirth = t - age; //Assign birth time from age.
-  A[n].sex = s;          //Assign sex.
-  A[n].state = st;       //Initialize TB Disease state
+  Af(n, InFunction) = fnc_BasicInd;
+  Af(n, id) = IDnew();      //Assign unique ID number
+  AttachH(n);               //Attach to database
+  InitAbinds(n);            //initialize contact bindinds
+  clear_times(n);           //Initialize times
+  CCweight(grp, n, 1.);     //Maximum probability to be chosen: Tendai
+  Af(n, rob) = rob;         //Set to rob
+  Af(n, groupID) = grp;     //Assign initial group
+  Aset(n, tBirth, t - age); //Assign birth time from age.
+  Af(n, sex) = s;           //Assign sex.
+  CCstate(grp, n, st);      //Initialize TB Disease state
   prog = 0.1;
   if (st)
   {                       //if state is > 0 diseased
-    latents += 1;         // increase latent pop
-    LTB[grp] += 1;        // in correct group
     we = t + Expon(prog); //  future time of progression
-    A[n].tProgress = we;
+    Aset(n, tProgress, we);
     if (we < t)
       Error(853.); //check for errors
   }
-  else
-  {                   // otherwise
-    uninfecteds += 1; // increase unininfected pop
-    UTB[grp] += 1;    //in correct group
-  }
-  q = A[n].state;
-  A[n].strain = 0;
-  A[n].tDeath = wd = t + LifeDsn(n, s, age, m1[q]); //Assign time of death.
-  if (wd < A[n].tBirth + age)
+  q = Af(n, state);
+  Af(n, strain) = 0;
+  wd = t + LifeDsn(n, s, age, m1[q]); //Assign time of death.
+  Aset(n, tDeath, wd);
+  if (wd < At(n, tBirth) + age)
     Error(612.2); //Check death time.
   if (wd < t)
     Error(850.); //check for errors
-  A[n].pending = wd < we ? pDeath : pProgress;
+  Af(n, pending) = wd < we ? pDeath : pProgress;
 
   Check_all_events(n);
 }
@@ -655,17 +709,14 @@ BasicInd(int yr, int n, int rob, dec age, int s, int grp, int st)
 REPORTING
 
 This function is called periodically to display the cumulative number of
-infections and other statistics. THIS FUNCTION SHOULD BE CALLED NO LESS THAN
-ONCE PER YEAR, in current set-up, so that births per year ('bpy') and immigrants
-per year ('ipy') can be updated at least each year. For generating mid-year
-population estimates, this function should be called at least TWICE per year,
-once at the beginning of the year and once mid-way through the year.
+infections and other statistics. The updates of parameters sensitive to the
+calendar year, and the mid-year population estimates, are done separately by
+'Update' and 'Census' (see 'ObserveStart').
 
 ENTRY: 'prog' contains the name of the program presently running.
        't' contains the current time.
        't0' contains the starting time.
-       'N' contains the value of each dynamical variable, index by the state
-         number ('qUTB', 'qPLTB', ...).
+       The group module holds the number in each group and state ('CCcount').
        'startsec' contains the wall-clock time of the start of the run.
        'kernel' defines the contagion kernel.
        'deaths' and 'events' contain the number of deaths and events since
@@ -686,8 +737,8 @@ ReportInit()
 
 Report(char *prog)
 {
-  int i, j, ac, r, y, yr;
-  dec z, age;
+  int r;
+  dec z;
   int z1, z2;
 
   //print to screen simulation infor and output labels
@@ -720,6 +771,11 @@ Report(char *prog)
   //Calculate result summarise
   z1 = CCgroup_size(UK);
   z2 = CCgroup_size(NUK);
+  popsize = CCcount(-1, -1); //Read the totals from the
+  uninfecteds = CCcount(-1, qUTB); //group module.
+  latents = CCcount(-1, qLTB);
+  actives = CCcount(-1, qATB);
+  dormants = CCcount(-1, qDTB);
 
   //Write results to screen.
   printf("%6.1f  \t%d	\t%d \t%d \t%d \t%d \t%d \t%d \t%d \t%d \t%d \t%d \t%d\n",
@@ -729,15 +785,47 @@ Report(char *prog)
   fprintf(fptr, "%.0f\t%d\t%d\t%d\t%d\t%d\t%d \t%d \t%d\t%d\t%d\t%d \t%d\n",
           t, popsize, uninfecteds, latents, actives, dormants, progressions, regressions, deaths, deathsTB, nbirths, z1, z2);
 
+  if (telemetry)
+    EventTelemetry(fptel); //Record the scheduler's work.
+
   fprintf(stderr, "  %.1f\r", t); //Update status indicator.
   fflush(stdout);
   fflush(stderr);                                                        //Make sure everything shows.
   deaths = progressions = regressions = deathsTB = events = nbirths = 0; //Clear time-step counters.
+}
 
-  /////////////////////////////////////////////////////////////////
-  //UPDATE TIME DEPENDENT PARAMETERS VALUES
-  /////////////////////////////////////////////////////////////////
-  y = (int)t; //Get calendar (integer) year.
+/*----------------------------------------------------------------------------*
+PERIODIC OBSERVERS
+
+Reports, updates of parameters sensitive to the calendar year, and mid-year
+population estimates are each driven by a clock run by the scheduler, so that
+they occur as events in their turn and nothing is checked after other events.
+Reports occur every 'tgap' years from the start, updates at the start of each
+calendar year, and estimates in the middle of each. The clocks are periodic
+with no noise, so they draw no random numbers.
+
+ENTRY: (ObserveStart) 'prog' contains the name of the program presently
+         running.
+       't' contains the current time.
+
+EXIT:  (ObserveStart) The clocks have been started.
+       (ReportG, Update, Census) The work of one tick has been done.
+*/
+
+static struct Clock Creport, Cupdate, Ccensus; //Clocks for the observers,
+static char *Rprog;                            //and the name for reports.
+
+ReportG()
+{
+  pt = t;
+  Report(Rprog);
+}
+
+Update()
+{
+  int y;
+
+  y = (int)(t + 0.5); //Get calendar (integer) year.
   if (y > lup)
   {
     if ((t >= interv - 1)) //Check to see if parameters
@@ -746,22 +834,34 @@ Report(char *prog)
       lup = y;
     }
   }
-  ////////////////////////////////////////////////////////////////////////
-  if ((t - y) > 0.3 && (t - y) < 0.7 && y > 1998) //Since computation is expensive
-  {                                               //only get population sizes when
-                                                  //necessary (mid-year).
-    for (j = 0; j < nC; j++)
-    {
-      immid = Clowest[j + 1] - Emptyc[j];
-      yr = y - (int)t0;                    //Get year array index.
-      for (i = Clowest[j]; i < immid; i++) //Loop through immigrants.
-      {
-        age = t - A[i].tBirth; //Get age and find age class.
-        ac = age < 15 ? 0 : age < 45 ? 1 : age < 65 ? 2 : 3;
-      }
-    } //Increment correct compartment
-      //for this individual.
-  }
+}
+
+Census()
+{
+  int j, q, y;
+
+  y = (int)t; //Get calendar (integer) year.
+  if (y <= 1998)
+    return 0;
+  for (j = 0; j < nC; j++) //Record the mid-year numbers in
+    for (q = q0; q <= q1; q++) //each group and state.
+      Nmid[j][q] = CCcount(j, q);
+}
+
+ObserveStart(char *prog)
+{
+  Rprog = prog;
+  Creport.type = Cupdate.type = Ccensus.type = 4; //Periodic, without noise.
+  Creport.rate = 1 / tgap;
+  Cupdate.rate = Ccensus.rate = 1;
+  Cupdate.next = floor(t) + 1; //Align the yearly clocks with the
+  Ccensus.next = floor(t) + 0.5; //calendar.
+  if (Ccensus.next <= t)
+    Ccensus.next += 1;
+
+  ClockStart(&Creport, ReportG);
+  ClockStart(&Cupdate, Update);
+  ClockStart(&Ccensus, Census);
 }
 
 /*----------------------------------------------------------------------------*
@@ -809,8 +909,9 @@ Final()
   FILE *cases, *pop;
 
   printf("\n");
-  size = (indiv + 3) * sizeof(struct Indiv); //Tendai is this linked to the psuedo individuals?
+  size = Abytes; //Records of the individuals and pseudo individuals.
   size += EventProfile("Final");
+  size += CCprofile("Final");
 
   tstepfin();
   {
@@ -942,10 +1043,10 @@ These are parameter values that can be externally define/fed into the simulation
 */
 
 char *pntab[] = //Table of parameter names.
-    {"my_id_0", "currentrun", "fnumber", "randseq", 0};
+    {"my_id_0", "currentrun", "fnumber", "randseq", "scheduler", "telemetry", "trace", 0};
 
 dec *patab[] = //Table of parameter addresses.
-    {&my_id_0, &currentrun, &fnumber, &randseq, 0};
+    {&my_id_0, &currentrun, &fnumber, &randseq, &scheduler, &telemetry, &trace, 0};
 
 #include "service.c"
 
@@ -37,8 +37,18 @@ struct Clock
   dec rel;    //Relative width of uniform noise, types 2-3 (see above)
   dec target; //Latest time for the next tick, types 2-3 (see above)
   dec *x, *y; //Cumulative distribution, types 3-4 (see 'RandF')
-  int nxy;
-}; //Number of elements in 'x' and 'y', types 3-4 (see 'RandF')
+  int nxy;    //Number of elements in 'x' and 'y', types 3-4 (see 'RandF')
+  int n;      //Event number, assigned by 'ClockStart'
+  int stop;   //Set by 'ClockStop' until the clock is started again
+  int (*fire)(); //Routine called at each tick, with the clock
+};
+
+#define CLOCK0 (INDIV + NPSEUDO) //Event number of the first clock.
+#define CLOCKS 8                 //Clocks provided for at the outset.
+
+static struct Clock **Cl; //Clocks started, by event number from
+static int Cln, Clm;      //'CLOCK0', their number, and room,
+static struct Clock *Clf; //and the clock whose tick is in progress.
 
 struct Clock ClockTick(struct Clock c)
 {
@@ -82,6 +92,92 @@ struct Clock ClockTick(struct Clock c)
 
   return c;
 }
+
+/*----------------------------------------------------------------------------*
+RUN CLOCKS IN THE SCHEDULER
+
+A clock is started once with 'ClockStart', and from then on the scheduler
+drives it: each tick is an ordinary scheduled event, numbered from 'CLOCK0'
+upward beyond every individual, and 'ClockFire' is called when one is
+dispatched. It calls the clock's routine and schedules the next tick. The
+clock's type, rate, and noise are read at each tick, so a caller may change
+them at any time without restarting the clock. Any number of clocks may run,
+each with its own event number; the scheduler provides for the numbers as they
+are used.
+
+ENTRY: (ClockStart) 'c' points to a clock whose 'type', 'rate', 'rel', and
+         distribution, as applicable, are set. It must remain in place while
+         the clock runs. If 'c.next' is later than the present, the first
+         tick is then, and periodic clocks keep that phase; otherwise it is
+         computed as for any other tick.
+       'fire' points to the routine to be called at each tick.
+       (ClockFire) 'n' contains the number of a clock event just dispatched.
+       (ClockStop) 'c' points to a clock that has been started.
+       't' contains the current time.
+
+EXIT:  (ClockStart) The first tick has been scheduled, and 'ClockStart'
+         contains the clock's event number.
+       (ClockFire) The clock's routine has been called and the next tick
+         scheduled.
+       (ClockStop) No further ticks will occur. The clock may be started again.
+         It may be stopped from its own routine, during a tick, or stopped
+         more than once.
+*/
+
+int ClockStart(struct Clock *c, int (*fire)())
+{
+  int k;
+
+  for (k = 0; k < Cln && Cl[k] != c; k++) //Reuse the number of a clock
+    ;                                     //started before, or assign
+  if (k == Cln)                           //the next.
+  {
+    if (Cln == Clm)
+    {
+      Clm = Clm ? 2 * Clm : CLOCKS;
+      if ((Cl = realloc(Cl, Clm * sizeof Cl[0])) == 0)
+        Error(911.8);
+    }
+    Cl[Cln++] = c;
+  }
+
+  c->n = CLOCK0 + k;
+  c->fire = fire;
+  c->stop = 0;
+  if (c->next > t)           //Schedule the first tick at the
+    c->target = c->next;     //time given, or compute it.
+  else
+    *c = ClockTick(*c);
+  EventSchedule(c->n, c->next);
+  return c->n;
+}
+
+int ClockFire(int n)
+{
+  struct Clock *c;
+
+  if (n < CLOCK0 || n >= CLOCK0 + Cln)
+    Error1(854., "n=", n); //Make sure the clock exists.
+  c = Cl[n - CLOCK0];
+
+  Clf = c;                      //Perform the tick, then schedule
+  c->fire(c);                   //the next, unless the clock's
+  Clf = 0;                      //routine has stopped it.
+  if (c->stop)
+    return;
+  *c = ClockTick(*c);
+  EventSchedule(c->n, c->next);
+}
+
+int ClockStop(struct Clock *c)
+{
+  if (c->stop)                  //Cancel the next tick, unless the
+    return;                     //clock is already stopped or the
+  c->stop = 1;                  //tick is in progress, when none
+  if (c != Clf)                 //is scheduled.
+    EventCancel(c->n);
+}
+
 /*
 Special considerations: The random number function 'Rand' should not generate
 values of precisely 1. Random number generators typically generated numbers
@@ -5,9 +5,19 @@ individuals and their characteristics, also the main space-consuming entity in
 the program.
 
 Time is encoded in 8-byte double-precision floating point values ('dec'), which
-is simple but a little extravagant. At the cost of a clarity time could be
-encoded in 4-byte unsigned integers instead, with a single floating point number
-defining the base year and time.
+is simple but a little extravagant. If 'TIME32' is set when the program is
+compiled, the times of each individual's events are held instead in 4-byte
+integers ('tcode'), counting 'TUPY' units per year from the base year 'TBASE',
+and the event scheduler holds its times in 4-byte ticks (see 'schedule.h').
+Times are converted by 'Tenc' and 'Tdec' on the way in and out, and read and
+set as 'At(n, f)' and 'Aset(n, f, x)', so the rest of the program continues to
+work in calendar years. A unit is about 4 seconds and the range 256 years on
+either side of the base year, which is the model's starting year 'T0'. Times
+earlier than that range, including zero, which marks times not in use, are held
+as 'TZERO' and return as zero. Later times, including infinite ones, are held as
+'TMAX' and return as infinite. Other times are rounded up to the next unit, so
+that no time returns earlier than it was set---in particular, earlier than the
+present.
 */
 
 #ifndef TYPEDEF
@@ -28,6 +38,7 @@ typedef unsigned int intu;
 //Initialize hashcoded names
 #define ID indiv      //10000
 #define NPSEUDO 2     //Number of pseudo individuals (clock driven)
+#define T0 1981       //Start time of model, years.
 #define Ncontacts 100 //Maximum number transmission and infection events per individual
 
 //TB TRANSITIONS:
@@ -38,6 +49,7 @@ typedef unsigned int intu;
 #define MaxE 3      //Maximum pending event (non-clock)
 //Clocks
 #define pBirth MaxE + 1 //Pending birth
+#define pClock MaxE + 2 //Tick of a clock (in traces only)
 
 // FUTURE TIMES:
 #define tDeath t[pDeath]       //Time for closure of this record
@@ -47,25 +59,90 @@ typedef unsigned int intu;
 #define tBirth t[pBirth]       //Time of initiation of this record
 #define MaxT MaxE + 1          //highest t index
 
+#ifndef TIME32
+#define TIME32 0 //Set to hold times in four bytes.
+#endif
+
+#if TIME32
+typedef int tcode;              //Time of an individual's event, in units of
+#define TUPY 8388608.           //'TUPY' per year from 'TBASE', with
+#define TBASE T0                //'TZERO' for zero and earlier times
+#define TZERO (-2147483647 - 1) //and 'TMAX' for later and infinite
+#define TMAX 2147483647         //ones.
+
+static inline tcode Tenc(dec x) //Convert a time to its code,
+{
+  x = (x - TBASE) * TUPY;
+  return x <= TZERO ? TZERO : x >= TMAX ? TMAX : (tcode)ceil(x);
+}
+
+static inline dec Tdec(tcode u) //and back.
+{
+  return u == TZERO ? 0. : u == TMAX ? HUGE_VAL : TBASE + u / TUPY;
+}
+#else
+typedef dec tcode; //Time of an individual's event, in years.
+#define Tenc(x) (x)
+#define Tdec(u) (u)
+#endif
+
+/* The fields of each record are held in one of two layouts, chosen by 'SOA'
+when the program is compiled. Normally they are held together, one structure for
+each individual, with the fields used by every event first so that they share a
+cache line. If 'SOA' is set each field is held instead in a separate column,
+indexed by individual, so that a pass over one field of the whole population
+reads nothing else, and 'struct Indiv' holds the addresses of the columns. The
+event times are held one column per event. Either way a field is reached as
+'Af(n, field)', for example 'Af(n, state)', and an event time as 'At(n, tDeath)'
+or 'At(n, t[i])', and the columns are allocated by 'AllocIndiv'. */
+
+#ifndef SOA
+#define SOA 0 //Set to hold the records as columns.
+#endif
+
+#if SOA
+struct Indiv //COLUMNS OF THE RECORDS
+{
+  tcode *t[MaxT + 1];    //Separate times for individual
+  intu *pending;         //Number of pending event
+  intu *state;           //Number of present state
+  unsigned int *groupID; //Group ID number
+  dec *v;                //Probability of being chosen: Tendai
+  unsigned int *id;      //individual's ID number: Tendai
+  unsigned int *idn;     //Next in the chain of ID numbers
+  intu *sex;             //Sex of this individual (0=female, 1=male)
+  intu *rob;             //Region of birth (0=Foreign-born, 1=UK-born)
+  intu *strain;          // infecting strain
+  intu *InFunction;      //current function number
+  int (*bto)[2];         //Binding list of infections by this individual
+  int (*bfrom)[2];       //Binding list of infections to other individual
+};
+#define Af(n, f) (A->f[n]) //Field 'f' of individual 'n'.
+#else
 struct Indiv //STRUCTURE OF EACH RECORD                   BYTES
 {
-  dec v; //Probability of being chosen: Tendai
+  //Fields used by every event:
+  tcode t[MaxT + 1];    //Separate times for individual           20/40
+  intu pending;         //Number of pending event                      4
+  intu state;           //Number of present state                      4
+  unsigned int groupID; //Group ID number, LW: this could be intu      4
+  dec v;                //Probability of being chosen: Tendai          8
   //id and idn are required for contacts
   unsigned int id;      //individual's ID number: Tendai, LW: this could be intu
   unsigned int idn;     //individual's ID number: Tendai, LW: this could be intu
-  dec t[MaxT + 1];      //Separate times for individual               64
-  unsigned int groupID; //Group ID number, LW: this could be intu
   intu sex;             //Sex of this individual (0=female, 1=male)    1
   intu rob;             //Region of birth (0=Foreign-born, 1=UK-born)  1
-  intu pending;         //Number of pending event                      1
-  intu state;           //Number of present state
   intu strain;          // infecting strain
   intu InFunction;      //current function number
   // bto and bfrom are required for binding lists
   int bto[2];   //Binding list of infections by this individual
   int bfrom[2]; //Binding list of infections to other individual
 
-} Aw; //                                            69 *
+}; //                                            80/104 *
+#define Af(n, f) (A[n].f) //Field 'f' of individual 'n'.
+#endif
+#define At(n, f) Tdec(Af(n, f))            //Time 'f' of individual 'n', in
+#define Aset(n, f, x) (Af(n, f) = Tenc(x)) //years, and its setting.
 
 extern struct Indiv *A; //List of individuals.
 
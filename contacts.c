@@ -54,11 +54,11 @@ EXIT: 'L' returns the index of the individual in the database array.
 int Li(int id)
 {
   int n;
-  for (n = H[id % ID];; n = A[n].idn)
+  for (n = H[id % ID];; n = Af(n, idn))
   {
     if (n == 0)
       Error(999.);
-    if (id == A[n].id)
+    if (id == Af(n, id))
       return n;
   }
 }
@@ -77,11 +77,11 @@ if the individual is no longer in the database.
 int Lz(int id)
 {
   int n;
-  for (n = H[id % ID];; n = A[n].idn)
+  for (n = H[id % ID];; n = Af(n, idn))
   {
     if (n == 0)
       return 0;
-    if (id == A[n].id)
+    if (id == Af(n, id))
       return n;
   }
 }
@@ -99,10 +99,10 @@ EXIT: The individual is linked.
 */
 void AttachH(int n)
 {
-  int id = A[n].id;
+  int id = Af(n, id);
   if (Lz(id))
     Error(997.);
-  A[n].idn = H[id % ID];
+  Af(n, idn) = H[id % ID];
   H[id % ID] = n;
 }
 
@@ -119,22 +119,22 @@ EXIT: The individual is unlinked and may be moved or deleted.
 void DetachH(int n)
 {
   int id, nprev;
-  id = A[n].id;
+  id = Af(n, id);
   n = H[id % ID];
   if (n == 0)
     Error(998.);
-  if (id == A[n].id)
+  if (id == Af(n, id))
   {
-    H[id % ID] = A[n].idn;
-    A[n].idn = 0;
+    H[id % ID] = Af(n, idn);
+    Af(n, idn) = 0;
     return;
   }
 
-  for (nprev = n, n = A[n].idn; n; nprev = n, n = A[n].idn)
-    if (id == A[n].id)
+  for (nprev = n, n = Af(n, idn); n; nprev = n, n = Af(n, idn))
+    if (id == Af(n, id))
     {
-      A[nprev].idn = A[n].idn;
-      A[n].idn = 0;
+      Af(nprev, idn) = Af(n, idn);
+      Af(n, idn) = 0;
       return;
     }
   //Error(997.); //what is the purpose for this error?
@@ -65,6 +65,7 @@ static char *message[] =
         "E735%s  An event to be scheduled is already scheduled",
         "E736%s  An event to be cancelled is not yet scheduled",
         "E737%s  A new event would be scheduled in the past",
+        "E738%s  Events cannot be dispatched while a batch is being loaded",
         "E742%s  Attempt to initialize when the time bins are not empty",
         "E753%s  A binary search table is invalid",
         "E754%s  A cumulative table has gone beyond 1",
@@ -72,13 +73,19 @@ static char *message[] =
         "F818%s  An existing event cannot be found in the time bins",
         "F819%s  The event counter has fallen negative",
         "F820%s  The event list has a broken link",
+        "F830%s  A replayed event differs from the trace",
+        "F831%s  A selection weight is out of range",
+        "F832%s  The strata do not match the number of groups",
+        "F833%s  An infection state is out of range",
         "F840%s  An internal inconsistency during file I/O has been detected",
         "F850%s  A birth occurred before the present",
         "F851%s  The width of a clock interval is too large",
         "F852%s  The specified type of clock is not supported",
         "F853%s  A progression occurred before the present",
+        "F854%s  A clock event has no clock",
 
         "F911%s  Not enough memory is available",
+        "F912%s  An output file cannot be opened",
         "F920%s  An index is out of range",
         "F921%s  A pointer is null",
         "F922%s  A switch index is incorrect",
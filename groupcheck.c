@@ -0,0 +1,120 @@
+/*----------------------------------------------------------------------------*
+GROUP MODULE CHECK
+
+This program exercises the group module, 'groups.c', with a stream of additions
+and deletions that drives additions into long cascades, and checks that the
+empty cells are rebalanced as documented there. Individuals are deleted from
+the highest group and added to the lowest, so that the empty cells collect at
+the high end and each addition cascades through more and more groups. The
+program checks that
+
+  1 'CCbalance' is called by 'CCadd' before long cascades ('Gl') have together
+    moved 'mA/GR' handles, and at least once in the run,
+  2 every cell in use holds a handle that records that cell, and every empty
+    cell holds none, and
+  3 each group holds the number of individuals added to it less those deleted,
+    and
+  4 every addition finds a cell.
+
+It is compiled from this file with 'error.c' and 'rand.c' and run as
+
+  groupcheck [adds]
+
+where 'adds' limits the number of additions, which otherwise continue until the
+highest group is empty. It displays the work of the module and returns zero if
+all checks pass.
+*/
+
+#include "common.h"
+
+#define nC 16 //Number of groups, enough for long cascades.
+
+struct Indiv *A; //List of individuals.
+dec t;           //(Unused time, for 'common.h'.)
+
+#include "groups.c"
+
+static int Nk[nC]; //Number expected in each group.
+
+/*----------------------------------------------------------------------------*
+CHECK THE GROUPS
+
+EXIT:  'check' contains zero if the groups are consistent, otherwise the
+         number of the failed check above.
+*/
+
+int check()
+{
+  int i, k, h;
+
+  for (k = 0; k < nC; k++)
+  {
+    h = Clowest[k + 1] - Emptyc[k];
+    if (h - Clowest[k] != Nk[k] || CCgroup_size(k) != Nk[k])
+      return 3;
+    for (i = Clowest[k]; i < Clowest[k + 1]; i++)
+      if (i < h ? Gh[i] == 0 || Gs[Gh[i]] != i : Gh[i] != 0)
+        return 2;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  int i, k, n, h, r, adds;
+
+  ErrorInit();
+  RandStart(1);
+  adds = argc > 1 ? atoi(argv[1]) : mA;
+  A = calloc(mA + 1, sizeof *A);
+  if (A == 0)
+    Error(911.);
+
+  for (k = 0, n = 1; k < nC; k++) //Divide the cells equally, as in
+  {                               //'GroupInit'.
+    Clowest[k] = n;
+    Emptyc[k] = mA / nC + (k >= nC - mA % nC);
+    n += Emptyc[k];
+    V[k] = 1;
+  }
+  Emptyc[nC] = 0;
+  Clowest[nC] = mA + 1;
+  CChandleInit();
+  CCweightInit();
+
+  for (k = 0, r = 0; k < nC && r == 0; k++)                 //Fill each group to
+    for (i = 0, h = Emptyc[k] * 9 / 10; i < h; i++, Nk[k]++) //nine tenths.
+    {
+      if ((n = CCadd(k)) == 0)
+      {
+        r = 4;
+        break;
+      }
+      Af(n, id) = 1;
+    }
+
+  for (i = 0; i < adds && Nk[nC - 1] && r == 0; i++) //Move individuals
+  {                                                  //from the highest
+    n = CCsel(nC - 1);                               //group to the lowest,
+    Af(n, id) = 0;                                   //checking as they go.
+    CCdel(nC - 1, n);
+    Nk[nC - 1] -= 1;
+    if ((n = CCadd(0)) == 0)
+    {
+      r = 4;
+      break;
+    }
+    Af(n, id) = 1;
+    Nk[0] += 1;
+    if (Gl >= mA / GR)
+      r = 1;
+    if (i % 4096 == 0 && r == 0)
+      r = check();
+  }
+  if (r == 0)
+    r = Gc.balances == 0 ? 1 : check();
+
+  CCprofile("Check");
+  printf("%s after %d additions\n", r ? "Failed check" : "Passed", i);
+  return r;
+}
@@ -63,18 +63,58 @@ cells and additions draw from them, where possible.
 'V' is the maximum probability of selection for any individual allowed in the
 class.
 
+In the program, the cells of 'A' described here are the array 'Gh', which holds
+for each cell a 32-bit handle, or zero if the cell is empty. The records of the
+individuals are in the array 'A' itself, indexed by handle, and never move while
+the individual is present. The hash table of identities and the event scheduler
+refer to individuals by handle, so when the groups are compacted only a handle
+is moved, with no record copied, rehashed, or renumbered in the scheduler.
+'Gs[n]' contains the cell holding handle 'n', and handles not in use are stacked
+in 'Gf'.
+
 'nA' and 'mA' are the current number and maximum number of individuals in 'A',
 respectively.
 
 'nC' is the current number and maximum number of groups.
 
+'Gd' contains the extent of each of the 'Gn' dimensions of a grid of strata, for
+example age band, sex, and region of birth, whose product is 'nC'. Group numbers
+run through the grid with the last dimension varying fastest, so a dimension
+along which individuals move in steps, such as age band, is best placed last.
+Its neighbours are then adjacent groups, and an individual moved to an adjacent
+group can usually be moved by shifting the boundary between the groups.
+
+When 'WEIGHTED' is set as the module is compiled, 'CCsel' selects in
+proportion to 'A[n].v' rather than uniformly, without the sieve's rejections,
+which become frequent when the probabilities within a group are skewed. Since
+each group occupies a contiguous stretch of 'A', a single Fenwick tree over the
+cells of 'Gh' serves all groups. It holds in 'Wv[c]' the weight of the individual
+in cell 'c', zero if empty, and gives the sum over any group, and the cell at
+which a given partial sum is reached, in O(log n) steps. 'CCweight' records a
+weight when it is assigned, and the weight is carried along with its handle
+whenever one moves between cells, so the tree follows every cascade in 'CCadd'
+and 'CCdel'.
+The tree is rebuilt from 'Wv' after every 'mA' updates, which costs O(1) per
+update and keeps rounding from accumulating in its partial sums.
+
 Three externally callable routines are included, 'CCsel', to select an
 individual randomly from a specified group, 'CCadd', to add individuals, and
 'CCdel', to delete individuals. Runtimes of all three are independent of the
 number of individuals being analysed. 'CCsel' will typically be combined with
 'RandF', which also is independent of the number of individuals. This entire
 module, therefore, is Order-1 on individuals, which is the most crucial
-variable.
+variable. 'CCselMany' draws several individuals from a group at once, with or
+without replacement, and 'CCgo' moves an individual from one group to another.
+'CCgrid' defines the grid of strata, and 'CCgroup' and 'CCstrata' convert
+between strata and group numbers. 'CCbalance' redistributes the empty cells
+among the groups, and 'CCprofile' displays the work of the cascades.
+
+The module also keeps, for each group and state, the number of individuals in
+'Gq' and the sum of their weights 'A[n].v' in 'Gw'. These are kept current by
+'CCadd', 'CCdel', and 'CCgo', and by 'CCstate' and 'CCweight', through which
+the state and weight of an individual present are changed. 'CCcount' and
+'CCvsum' read them, in constant time for one group and state, so reports and
+the force of infection need no scan of the population.
 
 EXAMPLE OF OPERATION
 
@@ -313,15 +353,51 @@ number of groups, and weakly on them.
     0   1   2   3   4   5   6    Clowest[i]
     4   4   4   4   4   4   3    E[i]
 */
-#define mA indiv + 1 //Maximum population size
+#define mA (indiv + 1) //Maximum population size
+#define GM 8 //Maximum number of dimensions of strata.
+#define GQ (q1 + 1) //Number of states counted in each group.
+#define GDEEP 2 //Groups a cascade may cross before it is long.
+#define GR 8    //Fraction of 'mA', inverted, that long cascades
+                //may move before the slack is rebalanced.
+#ifndef WEIGHTED
+#define WEIGHTED 0 //Set to select in proportion to 'A[n].v'.
+#endif
 //#define nC   3               //Maximum number of groups in 'C'. NUK;UK
 static int Clowest[nC + 2]; //Array of groups.
 static int Emptyc[nC + 2];  //Number of empty cells trailing each group.
 static dec V[nC + 2];       //Maximum probability in each group.
 static int nA = 0;          //Current number active in 'A'.
+static dec *Fw;             //Fenwick tree over the weights in 'Wv',
+static dec *Wv;             //the weight held for each cell in 'Gh',
+static int Wu;              //and updates since the tree was built.
+static int *Gh;             //Handle in each cell, zero if empty,
+static int *Gs;             //the cell holding each handle,
+static int *Gf;             //and handles free for reuse, with
+static int Gfn;             //their number.
+static int Ng[nC + 2];      //Growth of each group, and handles moved by
+static int Gl;              //long cascades, since the last rebalancing.
+static int Gz[nC + 2];      //(Working storage for 'CCbalance'.)
+static int Gq[nC + 2][GQ];  //Number in each group and state,
+static dec Gw[nC + 2][GQ];  //and the sum of their weights.
+
+static struct Gstats //Work of 'CCadd' since the start.
+{
+  dec adds;     //Cells provided.
+  dec cascades; //Those that cascaded through other groups,
+  dec depth;    //the groups they crossed,
+  dec depthmax; //the most crossed by any one,
+  dec moves;    //and handles they moved.
+  dec balances; //Rebalancing passes,
+  dec balanced; //and handles they moved.
+} Gc;
+static int Gd[GM] = {nC};   //Extent of each dimension of the strata,
+static int Gn = 1;          //and the number of dimensions.
 //static int   emax  = 5;    //Maximum number of empty slots per group.
 //static dec   draws = 0;    //Number of random draws.
 
+int CCwpick(int, int), CCweight(int, int, dec), CCbalance();
+static int wset(int, dec), wbuild();
+
 /*------------------------------------------------------------------------------
 1. SELECT INDIVIDUAL
 
@@ -334,6 +410,8 @@ ENTRY: 'k' contains the group to be sampled.
          the group. This is greater than zero but not greater than 'V[k]'.
 
 EXIT:  'CCsel' indexes the individual selected. If zero, the group is empty.
+         With 'WEIGHTED' set, each individual is selected in proportion to
+         'A[n].v'. Otherwise all in the group are equally likely.
 */
 
 int CCsel(int k)
@@ -351,8 +429,9 @@ int CCsel(int k)
   }         //group.
   while (1) //Select an individual randomly
   {
-    n = Clowest[k] + h * Rand(); //and use it if it corresponds to
-    if (A[n].id == 0)
+    n = Gh[WEIGHTED ? CCwpick(k, h) //and use it if it corresponds to
+                    : Clowest[k] + (int)(h * Rand())];
+    if (n == 0 || Af(n, id) == 0)
     {
       return 0;
     } //Skip deleted individuals
@@ -369,8 +448,6 @@ int CCsel(int k)
 2. ADD INDIVIDUAL
 
 ENTRY: 'k' contains the group for the new individual.
-       'Aw' contains the formatted record for the new individual. In
-         particular, 'Aw.v' contains the probability for the individual.
        'A' contains the list of individuals, ordered by group.
        'Clowest' indexes the first individual in each group.
        'Emptyc' contains the number of empty cells in each group.
@@ -380,9 +457,11 @@ ENTRY: 'k' contains the group for the new individual.
        'nA' contains the current number of individuals in 'A'.
        'nC' contains the number of groups.
 
-EXIT:  'CCadd' contains the index of an available entry in 'A' where the
+EXIT:  'CCadd' contains the handle of an available entry in 'A' where the
          individual should be added. If zero, none can be added.
-       'A', 'C', and 'E' are updated to include space for the new individual.
+       'A[n].state' is 'q0' and 'A[n].v' is zero, and the individual is
+         counted in group 'k' in that state.
+       'Gh', 'C', and 'E' are updated to include a cell for the new individual.
        'nA' is increased by one.
 
 Note: This routine must check for empty slots both in higher and lower numbered
@@ -404,15 +483,41 @@ example of how it works:
        0             1              2               3              4
 */
 
-int CCadd(int k)
+static int cmove(int c, int c0) //Move the handle in cell 'c0' to
+{                               //empty cell 'c', with its weight.
+  if (c == c0)
+    return 0;
+  Gh[c] = Gh[c0];
+  Gs[Gh[c]] = c;
+  Gh[c0] = 0;
+  if (WEIGHTED)
+  {
+    wset(c, Wv[c0]);
+    wset(c0, 0.);
+  }
+  return 1;
+}
+
+static int cshift(int c, int c0) //Move a handle as above, leaving the
+{                                //tree to be rebuilt ('CCbalance').
+  Gh[c] = Gh[c0];
+  Gs[Gh[c]] = c;
+  Gh[c0] = 0;
+  if (WEIGHTED)
+  {
+    Wv[c] = Wv[c0];
+    Wv[c0] = 0;
+  }
+  return 1;
+}
+
+static int cadd(int k) //Provide an empty cell in group 'k'.
 {
   int i, m, n, d, j;
   if (Clowest[0] == 0)
     return 0; //Guard against null cases.
   if (nA >= mA)
     return 0;
-  if (Aw.v > V[k])
-    Error(831.0); //Guard against invalid additions.
 
   for (d = 0; k - d >= 0 || k + d + 1 <= nC; d++) //Search forward and backward
   {
@@ -428,6 +533,24 @@ int CCadd(int k)
   if (i < 0)
     return 0;
 
+  d = i < k ? k - i : i - k;           //If the cascade would be long and
+  if (d > GDEEP && Gl && Gl + d >= mA / GR) //long ones have moved enough,
+  {                                    //rebalance the empty cells and
+    CCbalance();                       //search again.
+    return cadd(k);
+  }
+  Gc.adds += 1; //Count the addition and the
+  Ng[k] += 1;   //groups it crosses.
+  if (d)
+  {
+    Gc.cascades += 1;
+    Gc.depth += d;
+    if (d > Gc.depthmax)
+      Gc.depthmax = d;
+    if (d > GDEEP)
+      Gl += d;
+  }
+
   if (k <= i && i <= nC) //If there is a slot at the present
   {
     j = i;
@@ -443,7 +566,7 @@ int CCadd(int k)
       } //location.
       n = Clowest[j];
       if (m != n)
-        Transfer(m, n); //Swap position
+        Gc.moves += cmove(m, n); //Swap position
       Emptyc[j - 1] += 1;
       Clowest[j] += 1;
     }
@@ -464,7 +587,7 @@ int CCadd(int k)
       n = Clowest[j + 2] - 1;
       //n=Clowest[2+1]-Emptyc[j+1];
       if (m != n)
-        Transfer(m, n);
+        Gc.moves += cmove(m, n);
       Emptyc[j + 1] += 1;
       Clowest[j + 1] -= 1;
     }
@@ -473,10 +596,28 @@ int CCadd(int k)
   return 0; //Indicate the list is full.
 }
 
+int CCadd(int k)
+{
+  int c, n;
+  if (Gfn <= 0)
+    return 0;
+  c = cadd(k); //Find a cell and give it a free
+  if (c == 0)  //handle.
+    return 0;
+  n = Gf[--Gfn];
+  Gh[c] = n;
+  Gs[n] = c;
+  Af(n, state) = q0; //Count it in the lowest state,
+  Af(n, v) = 0;      //with no weight, until they are
+  Gq[k][q0] += 1;    //set ('CCstate', 'CCweight').
+  return n;
+}
+
 /*------------------------------------------------------------------------------
 3. DELETE INDIVIDUAL
 
 ENTRY: 'n' indexes the individual being deleted. 'A[n]' is ready for reuse.
+         Its handle is returned to 'Gf' for a later addition.
        'k' contains the group for former individual 'n'.
        'A' contains the list of individuals, ordered by group.
        'Clowest' indexes the first individual in each group.
@@ -499,27 +640,31 @@ worth it. That is something for possible later evaluation.
 
 int CCdel(int k, int n)
 {
-  int h, i, m;
-  if (Clowest[0] == 0 || k > nC)
+  int c, h, m;
+  if (Clowest[0] == 0 || k > nC || n <= 0 || n > mA || Gs[n] == 0)
     return 0; //Guard against null cases.
   h = Clowest[k + 1] - Clowest[k];
   if (h <= 0)
     return 0;
   if (Clowest[k + 1] - Clowest[k] - Emptyc[k] < 0)
     return 0; //Skip empty groups:Tendai
+  c = Gs[n];
+  Ng[k] -= 1;
+  Gq[k][Af(n, state)] -= 1; //Remove it from the counts.
+  Gw[k][Af(n, state)] -= Af(n, v);
   Emptyc[k] += 1;
   m = Clowest[k + 1] - Emptyc[k]; //Find the highest occupied index in group k i.e m
-  if (n == m || m == 0)           //If n is not the highest indexed individual corrected from n!=m on 06/10/16
+  if (c == m || m == 0)           //If n is not the highest indexed individual corrected from n!=m on 06/10/16
   {
-    A[n].id = 0;
-    clear_times(n);
-  } //Otherwise clear n's ID and clear all event
+    Gh[c] = 0;
+    wset(c, 0.);
+  } //Otherwise empty n's cell
   else
-  {
-    Transfer(n, m);
-    clear_times(m);
-    A[m].id = 0;
-  } //tranfer m into deleted position and update index times
+    cmove(c, m); //or move m's handle into it.
+  Af(n, id) = 0; //Clear n's ID and all event
+  clear_times(n); //times and free its handle.
+  Gs[n] = 0;
+  Gf[Gfn++] = n;
   nA -= 1;
   return 1; //Return with success.
 }
@@ -537,7 +682,7 @@ int clear_times(int n)
 {
   int i;
   for (i = 0; i < MaxT; i++)
-    A[n].t[i] = 0;
+    Aset(n, t[i], 0);
   return 1;
 }
 
@@ -563,6 +708,548 @@ int CCgroup_size(int k)
   return h;
 }
 
+/*------------------------------------------------------------------------------
+6. SELECTION WEIGHTS
+
+'CCweightInit' provides the tree, 'CCweight' sets the weight of an individual,
+'wset' the weight of a cell, 'CCwsum' returns a partial sum, and 'CCwpick'
+selects from a group by weight. Except for 'CCweight', which also keeps the
+sums in 'Gw', all return at once unless 'WEIGHTED' is set.
+
+ENTRY: 'n' contains the handle of an individual present in group 'k', or 'c' a
+         cell, and 'v' the new weight, not negative.
+       'k' contains a group and 'h' the number occupying it.
+
+EXIT:  'CCwsum' contains the sum of the weights in cells 1 through 'c'.
+       'CCwpick' indexes the cell selected from group 'k', or zero if the
+         weights in the group sum to zero.
+*/
+
+int CCweightInit()
+{
+  if (!WEIGHTED)
+    return 0;
+  free(Fw);
+  free(Wv);
+  Fw = calloc(mA + 1, sizeof *Fw);
+  Wv = calloc(mA + 1, sizeof *Wv);
+  if (Fw == 0 || Wv == 0)
+    Error(911.8);
+  Wu = 0;
+  return 1;
+}
+
+static int wbuild()
+{
+  int i, j;
+  for (i = 1; i <= mA; i++)      //Rebuild the tree from the weights
+    Fw[i] = Wv[i];               //in one pass, each node adding its
+  for (i = 1; i <= mA; i++)      //sum into its parent.
+  {
+    j = i + (i & -i);
+    if (j <= mA)
+      Fw[j] += Fw[i];
+  }
+  Wu = 0;
+  return 1;
+}
+
+static int wset(int c, dec v)
+{
+  int i;
+  dec d;
+  if (!WEIGHTED)
+    return 0;
+  if (v < 0 || c <= 0 || c > mA)
+    Error2(831.1, "c=", c, "` v=", v);
+  d = v - Wv[c];
+  if (d == 0)
+    return 1;
+  Wv[c] = v;
+  for (i = c; i <= mA; i += i & -i) //Add the change to each node
+    Fw[i] += d;                     //covering the cell.
+  if (++Wu >= mA)
+    wbuild();
+  return 1;
+}
+
+int CCweight(int k, int n, dec v)
+{
+  Gw[k][Af(n, state)] += v - Af(n, v);
+  Af(n, v) = v;
+  return wset(Gs[n], v);
+}
+
+dec CCwsum(int c)
+{
+  dec s;
+  for (s = 0; c > 0; c -= c & -c)
+    s += Fw[c];
+  return s;
+}
+
+int CCwpick(int k, int h)
+{
+  int i, n, lo;
+  dec b, s;
+  if (!WEIGHTED)
+    return 0;
+  lo = Clowest[k] - 1;
+  b = CCwsum(lo);
+  s = CCwsum(lo + h) - b;
+  if (s <= 0)
+    return 0;
+  s = b + s * Rand(); //Find the partial sum to reach,
+
+  for (i = 1; i * 2 <= mA; i *= 2)
+    ;
+  for (n = 0; i; i /= 2)          //then descend the tree for the last
+    if (n + i <= mA && Fw[n + i] <= s) //cell whose sum does not pass it.
+    {
+      n += i;
+      s -= Fw[n];
+    }
+  n += 1;
+
+  if (n <= lo) //Guard against rounding at the
+    n = lo + 1; //edges of the group.
+  if (n > lo + h)
+    n = lo + h;
+  return n;
+}
+
+/*------------------------------------------------------------------------------
+7. SELECT SEVERAL INDIVIDUALS
+
+This routine draws a number of individuals from a group in one call, for callers
+that would otherwise call 'CCsel' in a loop. With replacement, each is drawn as
+by 'CCsel'. Without replacement, a uniform sample is drawn by Floyd's algorithm,
+which takes one random number per individual drawn, regardless of the size of
+the group, with the offsets already drawn held in the hash set 'Sh'. With
+'WEIGHTED' set, each one drawn is given a weight of zero until the sample is
+complete, so that the remaining draws are in proportion to the remaining
+weights.
+
+Within a group, all cells below 'Clowest[k+1]-Emptyc[k]' hold individuals
+except one whose handle was returned by 'CCadd' and whose record is not yet
+filled. Such a hole is never retried. With replacement the next individual in
+the group is taken in its place; without replacement it is left out.
+
+ENTRY: 'k' contains the group to be sampled.
+       'c' contains the number of individuals to draw.
+       'r' is nonzero to draw with replacement and zero to draw without.
+       'x' points to an array with room for 'c' entries.
+
+EXIT:  'CCselMany' contains the number of individuals drawn, which is 'c' unless
+         the group is empty, holds fewer than 'c' without replacement, or
+         contains a hole.
+       'x' contains the handles of the individuals drawn, in no particular
+         order.
+*/
+
+static int *Sh; //Hash set of offsets drawn, and the
+static int Shm; //number of entries it holds.
+
+static int shput(int v) //Add 'v' to the set, or return zero
+{                       //if it is already there.
+  int i;
+  for (i = v & (Shm - 1); Sh[i] >= 0; i = (i + 1) & (Shm - 1))
+    if (Sh[i] == v)
+      return 0;
+  Sh[i] = v;
+  return 1;
+}
+
+int CCselMany(int k, int c, int x[], int r)
+{
+  int h, i, j, n, lo, m;
+
+  h = CCgroup_size(k); //Determine how many occupy the
+  if (h <= 0 || c <= 0) //group.
+    return 0;
+  lo = Clowest[k];
+
+  if (r) //With replacement, draw each one
+  {      //independently.
+    for (i = m = 0; i < c; i++)
+    {
+      n = WEIGHTED ? CCwpick(k, h) : lo + h * Rand();
+      for (j = 0; n && Af(Gh[n], id) == 0 && j < h; j++) //Pass over a hole.
+        n = n + 1 < lo + h ? n + 1 : lo;
+      if (n && Af(Gh[n], id))
+        x[m++] = Gh[n];
+    }
+    return m;
+  }
+
+  if (c > h)
+    c = h;
+  if (WEIGHTED) //Without replacement and weighted,
+  {             //withdraw the weight of each one as
+    for (i = m = 0; i < c; i++) //it is drawn, then restore it from 'A'.
+    {
+      n = CCwpick(k, h);
+      if (n == 0)
+        break;
+      x[m++] = Gh[n];
+      wset(n, 0.);
+    }
+    for (i = 0; i < m; i++)
+      wset(Gs[x[i]], Af(x[i], v));
+    for (i = j = 0; i < m; i++)
+      if (Af(x[i], id))
+        x[j++] = x[i];
+    return j;
+  }
+
+  if (Shm < 2 * c) //Provide a hash set at least twice
+  {                //the size of the sample.
+    for (Shm = 64; Shm < 2 * c; Shm *= 2)
+      ;
+    free(Sh);
+    Sh = malloc(Shm * sizeof *Sh);
+    if (Sh == 0)
+      Error1(911.9, "c=", c);
+  }
+  for (i = 0; i < Shm; i++)
+    Sh[i] = -1;
+
+  for (j = h - c, m = 0; j < h; j++) //Draw by Floyd's algorithm: take
+  {                                  //a random offset up to 'j', or 'j'
+    i = (j + 1) * Rand();            //itself if that one is already
+    if (!shput(i))                   //taken.
+      shput(i = j);
+    if (Af(Gh[lo + i], id))
+      x[m++] = Gh[lo + i];
+  }
+  return m;
+}
+
+/*------------------------------------------------------------------------------
+8. MOVE INDIVIDUAL TO ANOTHER GROUP
+
+This routine moves an individual from one group to another by moving its handle
+between cells. Its record and its events stay where they are. The move is one
+of the following, in order of preference:
+
+  (1) If the new group is next above the old, and the old group has an empty
+      cell or the individual is its last, the individual is placed in the last
+      cell of the old group and the boundary between them is moved down by
+      one. This moves at most two handles.
+  (2) If the new group is next below and has no empty cells, and the
+      individual is in the first cell of the old group, the boundary is moved
+      up by one, with nothing moved.
+  (3) If the new group has an empty cell, the individual is moved into it and
+      the last individual of the old group fills the cell vacated. This moves
+      at most two handles regardless of the distance between groups.
+  (4) Otherwise an empty cell is cascaded into the new group as by 'CCadd' and
+      the individual, wherever the cascade has left it, is handled as in (3).
+
+ENTRY: 'k' contains the group holding the individual.
+       'n' indexes the individual.
+       'g' contains the group to which it is to be moved.
+
+EXIT:  'CCgo' is zero if the move could not be made. The caller updates any
+         fields recording the group.
+*/
+
+static int gcount(int k, int g, int n) //Move the individual's counts
+{                                      //from group 'k' to 'g'.
+  Gq[k][Af(n, state)] -= 1;
+  Gw[k][Af(n, state)] -= Af(n, v);
+  Gq[g][Af(n, state)] += 1;
+  Gw[g][Af(n, state)] += Af(n, v);
+  return 1;
+}
+
+int CCgo(int k, int n, int g)
+{
+  int c, f, m;
+
+  if (Clowest[0] == 0 || k < 0 || k >= nC || g < 0 || g >= nC)
+    return 0; //Guard against null cases.
+  if (n <= 0 || n > mA)
+    return 0;
+  c = Gs[n];                          //Locate the individual and the
+  m = Clowest[k + 1] - Emptyc[k] - 1; //last in the group.
+  if (c < Clowest[k] || c > m)
+    return 0;
+  if (k == g)
+    return 1;
+  Ng[k] -= 1; //(Growth of 'g' is counted below.)
+  gcount(k, g, n);
+
+  if (g == k + 1 && (c == m || Emptyc[k])) //(1) Move the boundary
+  {                                        //down.
+    f = Clowest[g] - 1;
+    if (c != f)
+    {
+      cmove(f, c);
+      if (c != m)
+        cmove(c, m);
+    }
+    Clowest[g] -= 1;
+    Ng[g] += 1;
+    return 1;
+  }
+
+  if (g == k - 1 && Emptyc[g] == 0 && c == Clowest[k]) //(2) Move the
+  {                                                    //boundary up.
+    Clowest[k] += 1;
+    Ng[g] += 1;
+    return 1;
+  }
+
+  if (Emptyc[g] == 0) //(4) Cascade an empty cell into
+  {                   //the new group, following the
+    f = cadd(g);      //individual if it moves.
+    if (f == 0)
+    {
+      Ng[k] += 1;
+      gcount(g, k, n);
+      return 0;
+    }
+    nA -= 1;
+    c = Gs[n];
+    m = Clowest[k + 1] - Emptyc[k] - 1;
+  }
+  else
+  {
+    f = Clowest[g + 1] - Emptyc[g]; //(3) Take the first empty cell,
+    Emptyc[g] -= 1;
+    Ng[g] += 1;
+  }
+  cmove(f, c); //move the individual into it, and
+  if (c != m)  //fill its former cell.
+    cmove(c, m);
+  Emptyc[k] += 1;
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+9. STRATA
+
+'CCgrid' defines the dimensions of the grid of strata, 'CCgroup' returns the
+group for a set of strata, and 'CCstrata' returns the strata for a group.
+
+ENTRY: 'n' contains the number of dimensions and 'd' the extent of each, whose
+         product must be 'nC'.
+       's' contains a stratum for each dimension, or a place for one.
+       'k' contains a group.
+
+EXIT:  'CCgroup' contains the group holding stratum 's'.
+       's' contains the strata of group 'k' ('CCstrata').
+*/
+
+int CCgrid(int n, int d[])
+{
+  int i, c;
+
+  if (n < 1 || n > GM)
+    Error1(832.1, "n=", n);
+  for (i = 0, c = 1; i < n; i++)
+    c *= d[i];
+  if (c != nC)
+    Error2(832.2, "product=", c, "` nC=", nC);
+  for (i = 0; i < n; i++)
+    Gd[i] = d[i];
+  Gn = n;
+  return 1;
+}
+
+int CCgroup(int s[])
+{
+  int i, k;
+
+  for (i = k = 0; i < Gn; i++)
+  {
+    if (s[i] < 0 || s[i] >= Gd[i])
+      Error2(832.3, "dimension ", i, "` stratum ", s[i]);
+    k = k * Gd[i] + s[i];
+  }
+  return k;
+}
+
+int CCstrata(int k, int s[])
+{
+  int i;
+
+  for (i = Gn - 1; i >= 0; i--)
+  {
+    s[i] = k % Gd[i];
+    k /= Gd[i];
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+10. HANDLES
+
+This routine provides the arrays of handles when the groups are initialized,
+with every handle free, every cell empty, and no one counted.
+*/
+
+int CChandleInit()
+{
+  free(Gh);
+  free(Gs);
+  free(Gf);
+  Gh = calloc(mA + 2, sizeof *Gh);
+  Gs = calloc(mA + 2, sizeof *Gs);
+  Gf = calloc(mA + 2, sizeof *Gf);
+  if (Gh == 0 || Gs == 0 || Gf == 0)
+    Error1(911.11, "n=", mA);
+  for (Gfn = 0; Gfn < mA; Gfn++) //Stack the handles so the lowest
+    Gf[Gfn] = mA - Gfn;          //are given out first.
+  memset(Gq, 0, sizeof Gq); //No one is counted in any group.
+  memset(Gw, 0, sizeof Gw);
+  nA = 0;
+  return 1;
+}
+
+/*------------------------------------------------------------------------------
+11. REBALANCE EMPTY CELLS
+
+Deletions leave empty cells where the individuals were, while additions draw
+them from the nearest group that has any. When some groups grow and others
+shrink, as the UK-born grow through births while the non-UK-born shrink, the
+empty cells end up on the wrong side and additions cascade through every group
+in between. This routine moves the empty cells back in bulk. Half are shared
+equally among the groups and half in proportion to each group's growth since
+the last rebalancing. It is called by 'CCadd' when cascades crossing more than
+'GDEEP' groups have together moved 'mA/GR' handles, so that its cost, O(mA), is
+spread over at least that many moves, and may also be called at any time.
+
+The occupied cells of each group move as a block. Blocks moving down are moved
+first, from the lowest group up, then blocks moving up, from the highest group
+down, so that no block lands on one not yet moved.
+
+ENTRY: 'Ng' contains the growth of each group since the last rebalancing.
+
+EXIT:  The empty cells have been redistributed and 'Ng' and 'Gl' cleared.
+       'CCbalance' contains the number of handles moved.
+*/
+
+int CCbalance()
+{
+  int i, k, c, d, e, h, m;
+  dec w, W;
+
+  if (Clowest[0] == 0)
+    return 0; //Guard against null cases.
+  for (k = 0, e = 0, W = 0; k < nC; k++) //Total the empty cells and the
+  {                                      //growth, holding the number
+    e += Emptyc[k];                      //occupying each group in
+    Emptyc[k] = Clowest[k + 1] - Clowest[k] - Emptyc[k]; //'Emptyc'.
+    W += Ng[k] > 0 ? Ng[k] : 0;
+  }
+
+  Gz[0] = Clowest[0]; //Lay out the new groups.
+  for (k = 0, c = e; k < nC; k++)
+  {
+    w = W > 0 ? (Ng[k] > 0 ? Ng[k] : 0) / W : 1. / nC;
+    d = k < nC - 1 ? (int)(e / 2 / nC + (e - e / 2) * w) : c;
+    d = d > c ? c : d;
+    c -= d;
+    Gz[k + 1] = Gz[k] + Emptyc[k] + d;
+  }
+  Gz[nC] = Clowest[nC];
+
+  for (k = 0, m = 0; k < nC; k++) //Move blocks down, lowest first,
+    if (Gz[k] < Clowest[k])       //each in ascending order,
+      for (i = 0, h = Emptyc[k]; i < h; i++, m++)
+        cshift(Gz[k] + i, Clowest[k] + i);
+  for (k = nC - 1; k >= 0; k--) //then blocks up, highest first,
+    if (Gz[k] > Clowest[k])     //each in descending order.
+      for (i = Emptyc[k] - 1; i >= 0; i--, m++)
+        cshift(Gz[k] + i, Clowest[k] + i);
+
+  for (k = 0; k < nC; k++) //Record the new groups and
+  {                        //clear the growth.
+    Emptyc[k] = Gz[k + 1] - Gz[k] - Emptyc[k];
+    Clowest[k] = Gz[k];
+    Ng[k] = 0;
+  }
+  if (WEIGHTED)
+    wbuild();
+  Gl = 0;
+  Gc.balances += 1;
+  Gc.balanced += m;
+  return m;
+}
+
+/*------------------------------------------------------------------------------
+12. PROFILE
+
+ENTRY: 'label' contains a label for the display.
+
+EXIT:  The work of 'CCadd' since the start has been displayed, and 'CCprofile'
+         returns the memory the module occupies beyond 'A'.
+*/
+
+int CCprofile(char *label)
+{
+  printf("%s groups: %d individuals in %d groups, %.0f additions, %.0f cascaded"
+         " (mean depth %.2f, max %.0f, %.3f moves per addition), %.0f"
+         " rebalancings moved %.0f\n",
+         label, nA, nC, Gc.adds, Gc.cascades,
+         Gc.cascades ? Gc.depth / Gc.cascades : 0, Gc.depthmax,
+         Gc.adds ? Gc.moves / Gc.adds : 0, Gc.balances, Gc.balanced);
+  return 3 * (mA + 2) * sizeof(int) +
+         (WEIGHTED ? 2 * (mA + 1) * sizeof(dec) : 0);
+}
+
+/*------------------------------------------------------------------------------
+13. STATES AND AGGREGATES
+
+'CCstate' changes the state of an individual, moving it between the counts of
+its group, and 'CCcount' and 'CCvsum' return the number in a group and state and
+the sum of their weights.
+
+ENTRY: 'k' contains a group, or -1 for all groups.
+       'q' contains a state, or -1 for all states ('CCcount', 'CCvsum').
+       'n' indexes an individual present in group 'k' ('CCstate').
+
+EXIT:  'A[n].state' is 'q' ('CCstate').
+       'CCcount' contains the number of individuals in group 'k' and state 'q',
+         and 'CCvsum' the sum of their weights 'A[n].v'.
+*/
+
+int CCstate(int k, int n, int q)
+{
+  if (q < 0 || q >= GQ)
+    Error2(833.1, "n=", n, "` q=", q);
+  Gq[k][Af(n, state)] -= 1;
+  Gw[k][Af(n, state)] -= Af(n, v);
+  Gq[k][q] += 1;
+  Gw[k][q] += Af(n, v);
+  Af(n, state) = q;
+  return 1;
+}
+
+int CCcount(int k, int q)
+{
+  int j, i, c;
+  if (k >= 0 && q >= 0)
+    return Gq[k][q];
+  for (j = k < 0 ? 0 : k, c = 0; j < (k < 0 ? nC : k + 1); j++)
+    for (i = q < 0 ? 0 : q; i < (q < 0 ? GQ : q + 1); i++)
+      c += Gq[j][i];
+  return c;
+}
+
+dec CCvsum(int k, int q)
+{
+  int j, i;
+  dec w;
+  if (k >= 0 && q >= 0)
+    return Gw[k][q];
+  for (j = k < 0 ? 0 : k, w = 0; j < (k < 0 ? nC : k + 1); j++)
+    for (i = q < 0 ? 0 : q; i < (q < 0 ? GQ : q + 1); i++)
+      w += Gw[j][i];
+  return w;
+}
+
 /* CLARENCE LEHMAN AND ADRIENNE KEEN, JUNE 2011.
 
 Both authors contributed equally to this algorithm. It began in May 2010 with an
@@ -0,0 +1,254 @@
+/*----------------------------------------------------------------------------*
+HOLD-MODEL BENCHMARK
+
+This program measures the event scheduler by the classic "hold" model: the
+earliest event is removed and the same event is scheduled again at 't+X', with
+the number of events held constant. It is compiled from this file with
+'schedule.c', 'error.c', 'rand.c', 'randh.c', and 'fileio.c', and needs the
+life tables in 'mort.txt'.
+
+The increments 'X' are drawn from the mixture the model itself produces, so
+that the scheduler sees realistic spacings rather than a textbook uniform or
+exponential. Each event is one of these.
+
+  Progression  Exponential with rate 0.1 per year ('Progress').
+  Regression   Exponential with rate 0.2 per year ('Regress').
+  Death        Remaining lifetime from the life table 'M1' for the individual's
+               birth cohort, sex, and age, by 'RandF' ('LifeDsn'). An individual
+               who dies is replaced by a newborn, as births balance deaths.
+  Birth        A single periodic clock, one tick per year per 70 individuals.
+
+Population sizes run by factors of ten from 'nmin' to 'nmax'. For each the
+benchmark first holds each event about once, to bring the structures to a
+steady state, then times 'holds' further holds. The time taken to draw the increments alone, for the same sequence of
+events, is measured separately and subtracted to give a net figure for the
+scheduler alone. Cache misses are counted with the Linux performance counters,
+and shown as -1 where those are not available. The memory reported is that of
+the scheduler's structures, from 'EventProfile'.
+
+Parameters are given on the command line as in the model, for example
+
+  holdbench scheduler=1 nmin=10000 nmax=1000000 holds=2000000
+*/
+
+#include "common.h"
+#include "fileio.h"
+#include "schedule.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define AC 122  //Age classes and birth cohorts for
+#define BY (2010 - 1870 + 1) //mortality data, as in
+#define minBY 1870           //'Declarations.c'.
+#define PPROG 0.05 //Fraction of events that are progressions,
+#define PREG 0.05  //and that are regressions.
+#define YPB 70     //Years per birth per individual.
+
+struct Indiv *A; //(Referenced by messages in 'schedule.c'.)
+extern dec t;
+
+dec A1[AC];        //Ages matching the life tables,
+dec M1[BY][2][AC]; //the life tables themselves.
+struct IO fmt = {(dec *)M1, {-'b', BY, -'s', 2, -'a', AC}, {-'s', -'b', -'A'}};
+
+dec scheduler = -1; //Backend, or -1 for the compiled default.
+dec nmin = 1e4;     //Smallest and largest number of events.
+dec nmax = 1e7;
+dec holds = 1e6;    //Number of holds timed for each size.
+dec seed = 1;       //Random number sequence.
+
+static dec *Tb; //Time of birth of each individual.
+static char *Sx; //Sex of each individual.
+static int Nb;   //Number of the birth clock event.
+static char Rl[10][100]; //Lines of results, and their number.
+static int Rn;
+static int *Hs; //Events dispatched by the timed holds.
+
+dec RandF(dec[], dec[], int, dec);
+
+/*----------------------------------------------------------------------------*
+DRAW INCREMENT
+
+ENTRY: 'n' contains the number of the event just dispatched.
+       't' contains the present time.
+
+EXIT:  'incr' contains the time until the event's next occurrence. For deaths,
+         the individual has been replaced by a newborn.
+*/
+
+dec incr(int n)
+{
+  dec r;
+  int y;
+
+  if (n == Nb) //The birth clock ticks regularly.
+    return YPB / (dec)(Nb - 1);
+
+  r = Rand();
+  if (r < PPROG)
+    return Expon(0.1);
+  if (r < PPROG + PREG)
+    return Expon(0.2);
+
+  Tb[n] = t; //Otherwise the individual dies and
+  Sx[n] = Rand() < 0.5; //is replaced at birth.
+  y = (int)t - minBY;
+  y = y < 0 ? 0 : y >= BY ? BY - 1 : y;
+  return RandF(A1, M1[y][Sx[n]], AC, 0.);
+}
+
+/*----------------------------------------------------------------------------*
+COUNT CACHE MISSES
+
+'cstart' starts counting cache misses, and 'cstop' returns the number counted
+since, or -1 if the counters are not available.
+*/
+
+static int Cf = -1; //Counter file descriptor.
+
+int cstart()
+{
+#ifdef __linux__
+  struct perf_event_attr pe;
+
+  if (Cf < 0)
+  {
+    memset(&pe, 0, sizeof pe);
+    pe.type = PERF_TYPE_HARDWARE;
+    pe.size = sizeof pe;
+    pe.config = PERF_COUNT_HW_CACHE_MISSES;
+    pe.disabled = 1;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    Cf = syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+  }
+  if (Cf >= 0)
+  {
+    ioctl(Cf, PERF_EVENT_IOC_RESET, 0);
+    ioctl(Cf, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+}
+
+dec cstop()
+{
+  long long c;
+
+#ifdef __linux__
+  if (Cf >= 0)
+  {
+    ioctl(Cf, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(Cf, &c, sizeof c) == sizeof c)
+      return c;
+  }
+#endif
+  return -1;
+}
+
+/*----------------------------------------------------------------------------*
+RUN ONE SIZE
+
+ENTRY: 'n' contains the number of individuals.
+       'h' contains the number of holds to time.
+
+EXIT:  The backend's profile has been displayed and a line of results added
+         to 'Rl'.
+*/
+
+int bench(int n, int h)
+{
+  int i, j;
+  dec s0, s1, cm, mem, w;
+  clock_t c0;
+
+  EventInit(); //Start afresh with the backend
+  if (scheduler >= 0) //requested.
+    EventBackend((int)scheduler);
+  EventStartTime(T0);
+  EventCapacity(n + 1);
+
+  Nb = n + 1;
+  EventBatchBegin(); //Load a population of all ages,
+  for (i = 1; i <= n; i++) //with their first events.
+  {
+    Sx[i] = Rand() < 0.5;
+    Tb[i] = T0 - 80 * Rand();
+    j = (int)Tb[i] - minBY;
+    j = j < 0 ? 0 : j >= BY ? BY - 1 : j;
+    w = Rand();
+    EventSchedule(i, T0 + (w < PPROG ? Expon(0.1) : w < PPROG + PREG ? Expon(0.2) : RandF(A1, M1[j][Sx[i]], AC, T0 - Tb[i])));
+  }
+  EventSchedule(Nb, T0);
+  EventBatchCommit();
+
+  for (i = 0; i < n; i++) //Bring the structures to a
+  {                       //steady state.
+    j = EventNext();
+    EventSchedule(j, t + incr(j));
+  }
+
+  c0 = clock(); //Time the holds.
+  cstart();
+  for (i = 0; i < h; i++)
+  {
+    Hs[i] = j = EventNext();
+    EventSchedule(j, t + incr(j));
+  }
+  cm = cstop();
+  s1 = (dec)(clock() - c0) / CLOCKS_PER_SEC;
+
+  c0 = clock(); //Time the increments alone, for
+  for (i = 0, w = 0; i < h; i++) //the same events.
+    w += incr(Hs[i]);
+  s0 = (dec)(clock() - c0) / CLOCKS_PER_SEC;
+
+  mem = EventProfile("Benchmark");
+  sprintf(Rl[Rn++], "%10d %12d %10.1f %10.1f %12.2f %10.1f",
+          n, h, 1e9 * s1 / h, 1e9 * (s1 - s0) / h, cm < 0 ? -1 : cm / h,
+          mem / (1024 * 1024));
+  fflush(stdout);
+  return w > 0; //(Keep the increments computed.)
+}
+
+char *pntab[] = //Table of parameter names.
+    {"scheduler", "nmin", "nmax", "holds", "seed", 0};
+
+dec *patab[] = //Table of parameter addresses.
+    {&scheduler, &nmin, &nmax, &holds, &seed, 0};
+
+#include "service.c"
+
+int main(int argc, char *argv[])
+{
+  int i;
+  dec n;
+
+  ErrorInit();
+  gparam(argc, argv);
+  RandStart((unsigned long)seed);
+
+  for (i = 0; i < AC; i++) //Read the life tables.
+    A1[i] = i;
+  FileIO("mort.txt", fmt, "r|");
+
+  Tb = malloc((nmax + 2) * sizeof *Tb);
+  Sx = malloc(nmax + 2);
+  Hs = malloc(holds * sizeof *Hs);
+  if (Tb == 0 || Sx == 0 || Hs == 0)
+    Error(911.2);
+
+  for (n = nmin; n <= nmax * 1.000001 && Rn < 10; n *= 10) //Run each size.
+    bench((int)n, (int)holds);
+
+  printf("%10s %12s %10s %10s %12s %10s\n", "Events", "Holds", //Display
+         "ns/hold", "net ns", "misses/hold", "MB");             //the results.
+  for (i = 0; i < Rn; i++)
+    printf("%s\n", Rl[i]);
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*----------------------------------------------------------------------------*
+REPLAY EVENT TRACE
+
+This program feeds a trace recorded by the model (with parameter 'trace=1')
+back through the event scheduler, with no model logic, and reports the time
+taken. The trace holds every call the model made to the scheduler, in order,
+as described in 'schedule.h', so the scheduler sees exactly the stream of
+events of the recorded run. Scheduler changes can then be compared on real
+production workloads, separately from the cost of the model.
+
+Each 'EventNext' in the trace is checked against the event the scheduler
+returns. With the backend used for the recording they agree exactly. Another
+backend may dispatch events with equal times in a different order. That is
+counted, and the scheduler is brought back in line with the recording by
+cancelling the event recorded and putting back the one returned, at the same
+time, so the rest of the trace applies unchanged. Any other disagreement is an
+error.
+
+The program is compiled from this file with 'schedule.c' and 'error.c' and run
+as
+
+  replay summary_120_trace.bin [scheduler=N] [repeat=N]
+
+where 'scheduler' selects the backend as in the model and 'repeat' replays the
+trace several times for steadier timing.
+*/
+
+#include "common.h"
+#include "schedule.h"
+
+#define RB 65536 //Number of trace records read at a time.
+
+struct Indiv *A; //(Referenced by messages in 'schedule.c'.)
+extern dec t;
+
+static struct Etrace R[RB]; //Records read from the trace.
+
+/*----------------------------------------------------------------------------*
+REPLAY A TRACE
+
+ENTRY: 'fp' points to a trace file, positioned at the beginning.
+       'c' points to an array of counts, indexed by the type of record.
+
+EXIT:  Every call in the trace has been made to the scheduler.
+       'c' has been incremented for each record, and 'c[0]' for each event
+         dispatched in a different order from the recording and put back.
+*/
+
+int replay(FILE *fp, dec c[])
+{
+  int i, k, n;
+  struct Etrace *r;
+
+  while ((k = fread(R, sizeof R[0], RB, fp)) > 0)
+    for (i = 0; i < k; i++)
+    {
+      r = &R[i];
+      c[r->op & 127] += 1;
+      switch (r->op)
+      {
+      case 'I':
+        EventStartTime(r->t);
+        break;
+      case 'S':
+        EventSchedule(r->n, r->t);
+        break;
+      case 'C':
+        EventCancel(r->n);
+        break;
+      case 'M':
+        EventMove(r->n, r->m);
+        break;
+      case 'R':
+        EventReschedule(r->n, r->t);
+        break;
+      case 'B':
+        EventBatchBegin();
+        break;
+      case 'L':
+        EventBatchCommit();
+        break;
+      case 'N':
+        n = EventNext();
+        if (n == r->n)
+          break;
+        if (n == 0 || r->n == 0 || t != r->t)
+          Error3(830., "`record ", c['N'], "` n=", n, "` expected ", r->n);
+        EventCancel(r->n);    //Take the event recorded in
+        EventSchedule(n, t);  //place of the one with the same
+        c[0] += 1;            //time returned, which is still
+        break;                //to come.
+      case 'D':
+        break;
+      default:
+        Error1(513.1, "`op=", r->op);
+      }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+  int i, b, rep;
+  dec c[128], s, ops;
+  FILE *fp;
+  clock_t c0;
+
+  ErrorInit();
+  if (argc < 2)
+  {
+    printf("Usage: %s trace [scheduler=N] [repeat=N]\n", argv[0]);
+    return 1;
+  }
+
+  b = -1;
+  rep = 1;
+  for (i = 2; i < argc; i++) //Collect the parameters.
+    if (strncmp(argv[i], "scheduler=", 10) == 0)
+      b = atoi(argv[i] + 10);
+    else if (strncmp(argv[i], "repeat=", 7) == 0)
+      rep = atoi(argv[i] + 7);
+    else
+      Error2(525.1, argv[i], 0, "", 0);
+
+  fp = fopen(argv[1], "rb");
+  if (fp == 0)
+    Error2(510.1, argv[1], 0, "", 0);
+
+  for (i = 0; i < 128; i++)
+    c[i] = 0;
+  c0 = clock();
+  for (i = 0; i < rep; i++) //Replay the trace as often as
+  {                         //requested, starting afresh
+    EventInit();            //each time.
+    if (b >= 0)
+      EventBackend(b);
+    rewind(fp);
+    replay(fp, c);
+  }
+  s = (dec)(clock() - c0) / CLOCKS_PER_SEC;
+  fclose(fp);
+
+  ops = c['S'] + c['C'] + c['M'] + c['R'] + c['N'];
+  printf("Trace:       %s, replayed %d times\n", argv[1], rep);
+  printf("Calls:       %.0f schedule, %.0f cancel, %.0f move, %.0f reschedule,"
+         " %.0f next\n",
+         c['S'] / rep, c['C'] / rep, c['M'] / rep, c['R'] / rep, c['N'] / rep);
+  printf("Reordered:   %.0f events with equal times\n", c[0] / rep);
+  printf("Time:        %.3f seconds, %.1f ns per call\n\n",
+         s / rep, ops ? 1e9 * s / ops : 0);
+  EventProfile("Final");
+  return 0;
+}
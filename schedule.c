@@ -75,11 +75,12 @@ hundred million bins, for example, the average number in each bin is 1 and the
 average in each occupied bin is $1/(1-1/e) = 1.58$. Therefore, essentially no
 searching/sorting occurs, making the method exceedingly fast.
 
-It also has modest space requirements, with only two additional integers needed
-per event (one for a head-of-list index and another for a forward list index).
-Therefore, assuming four bytes per integer, managing 100 million events requires
-less than 3/4 gigabyte of memory, well within the reach even of laptop
-computers. ($8\times10^8/2^{30}$ GB).
+It also has modest space requirements, with only four additional integers
+needed per event (a head-of-list index, forward and backward list indexes, and
+the number of the list holding the event). Therefore, assuming four bytes per
+integer, managing 100 million events requires less than 1.5 gigabytes of
+memory, well within the reach even of laptop computers. ($1.6\times10^9/2^{30}$
+GB).
 
 Assuming the events occur at random times, then a portion $1/e = 0.36787944$ of
 the bins will be empty, the same portion will contain a single entry, $1/2e^2 =
@@ -141,35 +142,168 @@ experimental trials to find a good speed of operation.
 The linked lists of events in 'P' are not maintained in any particular order,
 for speed of addition, but before a bin is dispatched, it is sorted into order
 by event times, for speed of dispatching.
+
+Events beyond the present cycle are not placed in the bins at all. In this
+model most pending events are deaths drawn from life tables, decades in the
+future, and if they were binned they would be passed over on every cycle until
+their own cycle arrived. They are instead kept in a second, coarser tier 'F[b]',
+with one list per future cycle, 'FN' cycles deep, and a final list 'F[FN]' for
+anything further out still. When a cycle completes, the list for the next cycle
+is moved into the bins in a single pass, and the final list is checked for
+events that have come within range. Events with infinite times stay in the
+final list, counted in 'Qv', and are dispatched only when nothing else remains,
+as in the ladder queue. Lists in the far tier are doubly linked,
+with 'U' the backward index, so that an event can be cancelled without a search,
+and 'K[n]' records which list holds each event.
+
+The bins are doubly linked in the same way, and for events in a bin 'K[n]'
+holds the bin number itself. An event is thus cancelled by unlinking it from
+the list named in 'K[n]', with no search of the bin and no need to recompute
+the bin from 'T[n]'. The back links of a bin are restored after it is sorted.
+Bins are sorted by 'tsort' in 'schedules.c', which sorts on the event times
+directly rather than through the general routine 'sort'.
+
+Since good values for 'Qn' and 'Qw' depend on the size of the population and
+the rate of events, which vary greatly between runs, the module can tune them
+as it goes, in the manner of R. Brown's calendar queue (Communications of the
+ACM 31:1220-1227, 1988). Every 'QSAMPLE' dispatches the mean interval between
+dispatched events is examined. The number of bins is then set to the number of
+pending events, within the space available, and the width of each bin to 'QB'
+mean intervals. If either is off by more than a factor of two, all events are
+gathered into a single list and relinked into the new bins in one pass.
+
+When the bins greatly outnumber the events, as when event numbers run much
+higher than the population and the bins start at one per number, most bins are
+empty and stepping through them one at a time dominates dispatching. The module therefore
+keeps a hierarchical occupancy bitmap over the bins. Bit 'i' of 'B1' is set
+exactly when bin 'i' is non-empty, bit 'k' of 'B2' when word 'k' of 'B1' is
+non-zero, and likewise 'B3' over 'B2'. The next non-empty bin is found from at
+most a few words, with a count of trailing zero bits in each.
+
+Times may optionally be held as integer ticks rather than in floating point, as
+described in 'schedule.h'. The bins are then a power of two in number and in
+width, and the bin for an event is found by shifting and masking its time.
+
+The calendar queue is one of several interchangeable backends, each described
+in 'schedule.h'. The externally callable routines check their arguments and
+maintain the time of each event in 'T[n]', then pass control to the backend
+selected by 'SCHEDULER' at compile time or by 'EventBackend' at run time.
+Backends differ in how they link events together, but all use 'P[n]' to mark
+with 'PEMPTY' events that are not scheduled.
+
+Many cancellations are followed at once by scheduling the same event again, as
+when an individual's next event is recomputed. If 'LAZY' is set when the module
+is compiled, 'EventCancel' only marks the event in 'Ed' and leaves it with the
+backend, a single store. If the event is scheduled again before its old time
+arrives it is rescheduled in place; otherwise 'EventNext' discards it when it
+reaches the front. The backend then does no unlinking or searching on a cancel.
 */
 
 #include "common.h"
+#include "schedule.h"
 
 #define PINIT    \
   if (run1 == 0) \
     EventInit();
 
 #define PEMPTY -1            //Marker for bins containing no linkages.
-#define TN (INDIV + 0)       //Maximum number of time bins.
-#define PN (INDIV + NPSEUDO) //Maximum number of time bin forward indexes.
+#define PBATCH -2            //Marker for events held for a batch load.
+#define PAHEAD -3            //Marker for events taken ahead by 'EventNextBatch'.
+#define PN0 65536            //Number of events provided for at the outset.
 #define TW 20                //Time width of all bins combined (for optimization).
+#define FN 8                 //Number of future cycles held in the far tier.
+#define KF(b) (-1 - (b))     //Value in 'K' for far-tier list 'b', and the
+                             //reverse (bins are recorded as themselves).
+#define QTUNE 1              //Set to tune 'Qn' and 'Qw' as the run proceeds.
+#define QSAMPLE 65536        //Number of dispatches between tuning checks.
+#define QB 2                 //Mean intervals between events spanned by a bin.
+#define QNMIN 1024           //Smallest number of bins when tuning.
+#define N1 (Qm / 64 + 1)     //Number of words in each level of the
+#define N2 (N1 / 64 + 1)     //occupancy bitmap.
+#define N3 (N2 / 64 + 1)
+#define CTZ(x) __builtin_ctzll(x) //Count trailing zero bits.
+#define ER 4096              //Number of trace records buffered.
+#define TRACE(o, n, m, te) \
+  if (Etf)                 \
+    etrace(o, n, m, te);
+
+#ifndef SCHEDULER
+#define SCHEDULER 0 //Backend used unless changed by 'EventBackend'.
+#endif
+#ifndef LAZY
+#define LAZY 0 //Set to leave cancelled events with the backend.
+#endif
+
+#if TICKS //Convert times in years to and
+#define TICK(x) ((x) < Ez + TINF / TPY ? (etime)floor(((x) - Ez) * TPY + 0.5) : TINF)
+#define TIME(x) ((x) < TINF ? Ez + (x) / TPY : HUGE_VAL)
+#else //from times within the module.
+#define TICK(x) (x)
+#define TIME(x) (x)
+#endif
 
 dec t; //Current time, last dispatched event.
 
 static int run1; //Flag to detect if the routine is being reused.
 
-static dec T[PN]; //Time for each scheduled event.
-static int P[PN]; //Forward indexes within bins, ending with zero.
-static int Q[TN]; //First index for the bin, with zero for empty bins.
-
-static int Qn = TN; //Number of elements in 'Q'.
-static dec Qw = TW; //Interval of time represented for each cycle in 'Q'.
+static estore *T; //Time for each scheduled event.
+static dec Ez = 0;  //Starting time, from which ticks are counted.
+static int *P; //Forward indexes within bins, ending with zero.
+static int *Q; //First index for the bin, with zero for empty bins.
+static int *U; //Backward indexes within lists, zero at the head.
+static int *K; //Bin holding the event, or 'KF' of its far-tier list.
+static int Pn = 0; //Number of elements in 'T', 'P', 'U', and 'K'.
+static int Qm = 0; //Number of elements allocated for 'Q'.
+static int F[FN + 1]; //First index for each far-tier list, zero if empty.
+
+typedef unsigned long long word; //Word of the occupancy bitmap.
+static word *B1; //Bit set for each non-empty bin.
+static word *B2; //Bit set for each non-zero word of 'B1'.
+static word *B3; //Bit set for each non-zero word of 'B2'.
+
+static int Qn = 0;  //Number of elements of 'Q' in use.
+static etime Qw = TW; //Interval of time represented for each cycle in 'Q'.
 static int Qi = 0;  //Index of the immediate time bin.
 static int Qo = 1;  //Flag set if the immediate bin is in order.
-static int Qe = 0;  //Number of events in all bins.
-
-static dec Qt0 = 0;  //Earliest time representable this cycle in 'Q'.
-static dec Qt1 = TW; //Earliest time beyond this cycle in 'Q'.
+static int Qe = 0;  //Number of events in all bins and far-tier lists.
+static int Qf = 0;  //Number of events in far-tier lists,
+static int Qv = 0;  //and of them those with infinite times.
+static int Qc = 0;  //Number of cycles completed since the start.
+static int Qd = 0;  //Number of dispatches since the last tuning check.
+static dec Qg = 0;  //Sum of intervals between those dispatches.
+#if TICKS
+static int Qs = 0;  //Shift for the width of a bin, with 'TICKS'.
+static int Ql = 0;  //Shift for the number of bins, with 'TICKS'.
+#endif
+
+static etime Qt0 = 0;  //Earliest time representable this cycle in 'Q'.
+static etime Qt1 = TW; //Earliest time beyond this cycle in 'Q'.
+static etime Qtl = 0;  //Time of the last event dispatched.
+static struct Sortw Qsw; //Working storage for sorting bins.
+static struct Estats Es; //Counters since the last telemetry line.
+static FILE *Etf;            //Trace file, or zero if not tracing.
+static struct Etrace Er[ER]; //Trace records not yet written.
+static int Ern;              //Number of records in 'Er'.
+
+static struct Backend Eb[] = //Table of backends.
+    {
+        /*0*/ {"calendar queue", CalInit, CalStart, CalSchedule, CalCancel,
+               CalMove, CalReschedule, CalLoad, CalNext, CalProfile},
+        /*1*/ {"4-ary heap", HeapInit, HeapStart, HeapSchedule, HeapCancel,
+               HeapMove, HeapReschedule, HeapLoad, HeapNext, HeapProfile},
+        /*2*/ {"ladder queue", LadInit, LadStart, LadSchedule, LadCancel,
+               LadMove, LadReschedule, LadLoad, LadNext, LadProfile},
+        {0}};
+
+static struct Backend *Eq = &Eb[SCHEDULER]; //Backend in use.
+static int En = 0;                          //Number of events scheduled.
+static int Eb1 = 0;                         //Flag set while loading a batch.
+static int *Eo = 0;                         //Events taken ahead, in order,
+static int Eoh = 0, Eot = 0, Eoc = 0;       //from 'Eo[Eoh]' to 'Eo[Eot-1]',
+static etime Elast = -TINF;                 //with room for 'Eoc', and the time
+                                            //of the last taken from the backend.
+static char *Ed;                            //Flag for each event cancelled but
+static int Edn = 0;                         //still held, and their number.
 
 /*----------------------------------------------------------------------------*
 INITIALIZE STATIC DATA STRUCTURES
@@ -188,30 +322,115 @@ EventInit()
 {
   int i;
 
-  for (i = 0; i < PN; i++)
+  if (Pn == 0)     //Allocate the arrays the first
+    grow(PN0);     //time through.
+  for (i = 0; i < Pn; i++)
     P[i] = PEMPTY;
   if (run1 == 0)
   {
     run1 = 1;
+    Eq->init();
     return 0;
   } //Tendai changed return to return 0; to avoid warnings
 
-  for (i = 0; i < PN; i++)
+  for (i = 0; i < Pn; i++)
     T[i] = 0;
-  for (i = 0; i < TN; i++)
-    Q[i] = 0;
-
-  Qn = TN;
-  Qw = TW;
-  Qi = 0;
-  Qo = 1;
-  Qe = 0;
-  Qt0 = 0;
-  Qt1 = TW;
 
+  Eq->init();
+  memset(&Es, 0, sizeof Es);
+  En = 0;
+  Eb1 = 0;
+  Eoh = Eot = 0;
+  Elast = -TINF;
+  if (LAZY)
+    memset(Ed, 0, Pn);
+  Edn = 0;
   t = 0;
 }
 
+/*----------------------------------------------------------------------------*
+SELECT BACKEND
+
+This routine selects the data structure that will hold scheduled events. It may
+be called only while no events are scheduled, normally just after 'EventInit'.
+
+ENTRY: 'b' contains the number of the backend, an index into 'Eb'.
+         0 Calendar queue (this module)
+         1 Indexed 4-ary heap ('scheduleh.c')
+         2 Ladder queue ('schedulel.c')
+
+EXIT:  'EventBackend' contains the name of the backend now in use.
+*/
+
+char *EventBackend(int b)
+{
+  PINIT; //Initialize if necessary.
+
+  if (En)
+    Error(742.1); //Make sure no events are pending.
+  if (b < 0 || b >= sizeof Eb / sizeof Eb[0] - 1)
+    Error1(922.1, "scheduler=", b);
+
+  Eq = &Eb[b];
+  Eq->init();
+  return Eq->name;
+}
+
+/*----------------------------------------------------------------------------*
+PROVIDE FOR EVENTS
+
+The arrays indexed by event number are allocated at run time. They start with
+room for 'PN0' events and double whenever an event is numbered beyond them, so
+that a small run occupies little memory and a large one needs no change to
+'INDIV'. A caller that knows the highest number it will use can provide for it
+at the outset with 'EventCapacity', avoiding the copying as the arrays grow.
+
+ENTRY: (EventCapacity) 'n' contains the highest event number to provide for.
+       (grow) 'n' contains the number of elements wanted.
+
+EXIT:  (EventCapacity) 'EventCapacity' contains the number of elements
+         provided, at least 'n+1'.
+       (grow) 'T', 'P', 'U', and 'K' hold at least 'n' elements, with their
+         contents preserved and any new events unscheduled.
+*/
+
+int EventCapacity(int n)
+{
+  PINIT; //Initialize if necessary.
+
+  if (n >= Pn)
+    grow(n + 1);
+  return Pn;
+}
+
+int grow(int n)
+{
+  int i;
+
+  if (n <= Pn)
+    return 0;
+  n = n < 2 * Pn ? 2 * Pn : n; //Grow geometrically.
+
+  T = realloc(T, n * sizeof T[0]);
+  P = realloc(P, n * sizeof P[0]);
+  U = realloc(U, n * sizeof U[0]);
+  K = realloc(K, n * sizeof K[0]);
+  if (LAZY)
+    Ed = realloc(Ed, n);
+  if (T == 0 || P == 0 || U == 0 || K == 0 || (LAZY && Ed == 0))
+    Error1(911.4, "n=", n); //Make sure the storage was found.
+
+  for (i = Pn; i < n; i++) //Mark the new events unscheduled.
+  {
+    T[i] = 0;
+    P[i] = PEMPTY;
+    U[i] = K[i] = 0;
+    if (LAZY)
+      Ed[i] = 0;
+  }
+  Pn = n;
+}
+
 /*----------------------------------------------------------------------------*
 SET STARTING TIME
 
@@ -231,13 +450,14 @@ EventStartTime(dec t0)
 {
   PINIT; //Initialize if necessary.
 
-  if (Qe)
+  if (En)
     Error(742.); //Make sure the bins are empty.
 
-  Qt0 = t0 - (Qw / Qn) / 2; //Set the time boundaries, leaving
-  Qt1 = Qt0 + Qw;           //room for rounding errors.
-
-  t = t0; //Set the global time.
+  TRACE('I', 0, 0, t0);
+  Ez = t0;             //Count ticks from the start,
+  Eq->start(TICK(t0)); //position the backend, and set
+  t = t0;              //the global time.
+  Elast = TICK(t0);
 }
 
 /*
@@ -250,6 +470,27 @@ first bin, but rather in the last, and would not come out of the list in
 proper order. Positioning it in the middle prevents that.
 */
 
+/*----------------------------------------------------------------------------*
+DESCRIBE AN EVENT IN ERROR
+
+ENTRY: 'n' contains the number of an event about to be reported in error.
+       'A' points to the list of individuals, or is zero if there is none, as
+         when a trace is replayed.
+
+EXIT:  The time, the event number, and, if the event belongs to an individual
+         in 'A', the individual's routine, pending event, state, and identity
+         have been displayed. Clocks and other numbers beyond 'A' show only the
+         time and number.
+*/
+
+int whose(int n)
+{
+  if (A && n > 0 && n < INDIV + NPSEUDO)
+    printf("t=%f,fnc=%d, pending=%d, n=%d, state=%d,id=%d\n", t, Af(n, InFunction), Af(n, pending), n, Af(n, state), Af(n, id));
+  else
+    printf("t=%f, n=%d\n", t, n);
+}
+
 /*----------------------------------------------------------------------------*
 SCHEDULE NEW EVENT
 
@@ -259,46 +500,51 @@ ENTRY: 'n' contains the number (starting with 1) of a new event.
 
 EXIT:  The event has been scheduled, to occur when the proper time arrives.
        'T[n]' records the time 'te' of the event.
-       'P[n]' links the event with others in its time bin.
+       'P[n]' is no longer 'PEMPTY'.
 
 WORK:  The scheduling data structures are prepared as described above.
 */
 
 EventSchedule(int n, dec te)
 {
-  int i;
-  dec tr;
-
   PINIT; //Initialize if necessary.
 
-  if (n < 1 || n >= PN)
+  if (n < 1)
   {
-    printf("t=%f,fnc=%d, pending=%d, n=%d, state=%d,id=%d\n", t, A[n].InFunction, A[n].pending, n, A[n].state, A[n].id);
+    whose(n);
     Error1(734.1, "n=", n);
-  } //Check the index and make sure an
-  if (P[n] != PEMPTY)
+  } //Check the index, providing for
+  if (n >= Pn) //it if necessary, and make sure an
+    grow(n + 1);
+  if (P[n] != PEMPTY && !(LAZY && Ed[n]))
   {
-    printf("t=%f,fnc=%d, pending=%d, n=%d, state=%d,id=%d\n", t, A[n].InFunction, A[n].pending, n, A[n].state, A[n].id);
+    whose(n);
     Error1(735.1, "n=", n);
   } //event is not already scheduled
   if (te < t)
   {
-    printf("t=%f,fnc=%d, pending=%d, n=%d, state=%d,id=%d\n", t, A[n].InFunction, A[n].pending, n, A[n].state, A[n].id);
+    whose(n);
     Error2(737., "t=", t, ">", te);
   } //and is not in the past.
 
-  T[n] = te; //Record the time of the new event.
-
-  tr = (te - Qt0) / Qw;
-  tr -= (int)tr; //Convert the time to a bin number
-  i = tr * Qn;
-  if (i == Qi)
-    Qo = 0; //and mark for sorting if needed.
-
-  P[n] = Q[i];
-  Q[i] = n; //Add the event to the list for
-  Qe += 1;  //that bin and increment the number
-} //of events.
+  TRACE('S', n, 0, te);
+  T[n] = TICK(te); //Record the time of the new event,
+  En += 1;         //increment the number of events,
+  Es.scheduled += 1;
+  if (LAZY && Ed[n]) //and revive it if it was cancelled
+  {                  //but is still held,
+    Ed[n] = 0;
+    Edn -= 1;
+    retime(n, TICK(te));
+    return 0;
+  }
+  if (Eb1) //or pass it on, or hold it for
+  {        //the batch.
+    P[n] = PBATCH;
+    return 0;
+  }
+  enter(n);
+}
 
 /*----------------------------------------------------------------------------*
 
@@ -314,100 +560,210 @@ WORK:  The scheduling data structures are prepared as described above.
 
 EventCancel(int n)
 {
-  int i, j, jp;
-  dec tr;
-
   PINIT; //Initialize if necessary.
-  if (n < 1 || n >= PN)
+  if (n < 1 || n >= Pn)
   {
-    printf("t=%f,fnc=%d, pending=%d, n=%d, state=%d,id=%d\n", t, A[n].InFunction, A[n].pending, n, A[n].state, A[n].id);
+    whose(n);
     Error1(734.2, "n=", n);
   } //Check the index and make sure an
-  if (P[n] == PEMPTY)
+  if (P[n] == PEMPTY || (LAZY && Ed[n]))
   {
-    printf("t=%f,fnc=%d, pending=%d, n=%d, state=%d,id=%d\n", t, A[n].InFunction, A[n].pending, n, A[n].state, A[n].id);
+    whose(n);
     Error1(736.2, "n=", n);
   } //event is scheduled.
 
-  tr = (T[n] - Qt0) / Qw;
-  tr -= (int)tr; //Convert the time to a bin number,
-  i = tr * Qn;   //modulo the duration of the cycle.
-
-  if (cancel1(n, i))
-    return 0; //Tendai changed return to return 0; to avoid warnings
-              //Remove it from its normal bin.
-
-  i = (i - 1 + Qn) % Qn; //If it is not there, check the
-  if (cancel1(n, i))
-    return 0; //Tendai changed return to return 0; to avoid warnings                  //bin below (from rounding error).
-
-  i = (i + 2 + Qn) % Qn; //Finally, check the bin above.
-  if (cancel1(n, i))
-    return 0; //Tendai changed return to return 0; to avoid warnings
-
-  Error1(818., "n=", n); //If the specified event was not in
-} //the list, signal an error.
-
-int cancel1(int n, int i)
-{
-  int j, jp;
-
-  for (jp = 0, j = Q[i]; j > 0; jp = j, j = P[j]) //Scan the list of pending events
-    if (j == n)                                   //in this bin and remove the
-    {
-      if (jp > 0)
-        P[jp] = P[j]; //specified event. (The average
-      else
-        Q[i] = P[j]; //number events in a non-empty bin
-      P[j] = PEMPTY; //is 1.5)
-      Qe -= 1;
-      if (Qe < 0)
-        Error2(819., "n=", n, " bin=", i);
-      return 1;
-    }
-  return 0;
+  TRACE('C', n, 0, 0);
+  En -= 1; //Remove it from the batch or from
+  Es.cancelled += 1;
+  if (P[n] == PBATCH) //the events taken ahead, or from
+    P[n] = PEMPTY;    //the backend.
+  else if (P[n] == PAHEAD)
+    aremove(n);
+  else if (LAZY) //With 'LAZY', leave it with the
+  {              //backend, marked.
+    Ed[n] = 1;
+    Edn += 1;
+  }
+  else
+    Eq->cancel(n);
 }
 
-/*
-Note: It is necessary to check not just the expected bin when an event is to be
-deleted, but the two adjacent bins as well if the event does not appear. This is
-because of the vagaries of finite-precision computer arithmetic. Two bins are
-separated by a knife-edge, and what is calculated one time as 1.0 may be
-calculated in a slightly different manner as 0.999999999999999, dropping it in
-an adjacent bin. In simulations testing this condition, it happened only once
-per ten million times or less, so there is no speed issue here, only a
-correctness issue.
-*/
-
 /*----------------------------------------------------------------------------*
-RENUMBER EXISTING EVENT
+MOVE EXISTING EVENT
 
 This routine renumbers events. It can be called, for example, to reuse an entry
 when it becomes available, for example from a simulated death, shifting an
-existing individual from the end of the array keep the array compact.
+existing individual from the end of the array keep the array compact. The event
+keeps its place in the backend under its new number; nothing is cancelled and
+nothing rescheduled.
 
 ENTRY: 'n' contains the new index number, which has no event scheduled.
        'm' contains the current index number of the event.
        There is an event scheduled for 'm'.
 
 EXIT:  'n' is the new index number of the individual.
-       The event originally scheduled as 'm' is re-scheduled as 'n'. Event 'm'
+       The event originally scheduled as 'm' is now scheduled as 'n'. Event 'm'
          no longer has an event scheduled and the index is free to be reused.
 */
 
-EventRenumber(int n, int m)
+EventMove(int n, int m)
 {
-  if (n < 1 || n >= PN)
+  PINIT; //Initialize if necessary.
+
+  if (n < 1)
     Error1(734.3, "n=", n); //Check the indexes and make sure
-  if (m < 1 || m >= PN)
-    Error1(734.4, "n=", m); //they are in range.
+  if (m < 1 || m >= Pn)     //they are in range, providing for
+    Error1(734.4, "n=", m); //the new one if necessary.
+  if (n >= Pn)
+    grow(n + 1);
+  if (n == m)
+    return 0;
+  if (P[m] == PEMPTY || (LAZY && Ed[m]))
+    Error1(736.3, "n=", m); //Make sure the old number has an
+  if (LAZY && Ed[n])        //event and the new one does not,
+  {                         //discarding any cancelled event
+    Eq->cancel(n);          //still held.
+    Ed[n] = 0;
+    Edn -= 1;
+  }
+  if (P[n] != PEMPTY)
+    Error1(735.3, "n=", n);
 
-  if (n != m)
+  TRACE('M', n, m, 0);
+  T[n] = T[m];        //Transfer the time and have the
+  if (P[m] == PBATCH) //backend substitute the new number.
+  {
+    P[n] = PBATCH;
+    P[m] = PEMPTY;
+  }
+  else if (P[m] == PAHEAD)
   {
-    T[n] = T[m];    //Transfer the time.
-    EventCancel(m); //Cancel the old number.
-    EventSchedule(n, T[n]);
-  } //Reschedule as the new number.
+    Eo[afind(m)] = n;
+    P[n] = PAHEAD;
+    P[m] = PEMPTY;
+  }
+  else
+    Eq->move(n, m);
+}
+
+EventRenumber(int n, int m) //(Former name, kept for existing
+{                           //callers.)
+  EventMove(n, m);
+}
+
+/*----------------------------------------------------------------------------*
+RESCHEDULE EVENT
+
+This routine changes the time of an event, or schedules it if it has no event.
+It replaces the pair 'EventCancel' and 'EventSchedule' when an individual's
+next event is recomputed, and when the new time falls in the same place in the
+backend it only records the new time.
+
+ENTRY: 'n' contains the number (starting with 1) of an event, scheduled or not.
+       'te' contains the new time of the event.
+
+EXIT:  The event is scheduled to occur at time 'te'.
+       'T[n]' records the time 'te' of the event.
+*/
+
+EventReschedule(int n, dec te)
+{
+  PINIT; //Initialize if necessary.
+
+  if (n < 1)
+    Error1(734.5, "n=", n); //Check the index and make sure the
+  if (n >= Pn || P[n] == PEMPTY || (LAZY && Ed[n])) //event is scheduled,
+  {                                                 //scheduling it directly
+    EventSchedule(n, te);                           //if not.
+    return 0;
+  }
+  if (te < t)
+    Error2(737.1, "t=", t, ">", te); //Make sure it is not in the past.
+
+  TRACE('R', n, 0, te);
+  Es.rescheduled += 1;
+  if (P[n] == PBATCH) //Have the backend adjust it,
+  {                   //unless it is held for a batch.
+    T[n] = TICK(te);
+    return 0;
+  }
+  retime(n, TICK(te));
+}
+
+/*----------------------------------------------------------------------------*
+CHANGE TIME OF A HELD EVENT
+
+ENTRY: 'n' contains an event held by the backend or taken ahead.
+       'te' contains its new time, in ticks.
+
+EXIT:  The event is held at time 'te', which is recorded in 'T[n]'.
+*/
+
+int retime(int n, etime te)
+{
+  if (P[n] == PAHEAD || te < Elast)
+  {
+    if (P[n] == PAHEAD) //Events taken ahead, or that are
+      aremove(n);       //to join them, are removed and
+    else                //entered again.
+      Eq->cancel(n);
+    T[n] = te;
+    enter(n);
+    return 0;
+  }
+  Eq->reschedule(n, te);
+}
+
+/*----------------------------------------------------------------------------*
+LOAD EVENTS IN A BATCH
+
+These routines bracket the scheduling of a large number of events at once, as
+when the initial population is set up. Between them, 'EventSchedule' and the
+other routines only record times in 'T' and mark events in 'P' as held for the
+batch. 'EventBatchCommit' then gathers the held events in one pass and gives
+them to the backend together, which can arrange them more cheaply than one at
+a time---the calendar queue links each in its bin and sorts only the bin being
+dispatched, and the heap is built from the bottom up in linear time. Events may
+not be dispatched while a batch is being loaded.
+
+ENTRY: (EventBatchBegin) No significant conditions.
+       (EventBatchCommit) 'EventBatchBegin' has been called.
+
+EXIT:  (EventBatchBegin) Events scheduled are held for the batch.
+       (EventBatchCommit) All events held have been passed to the backend and
+         events are again scheduled individually.
+*/
+
+EventBatchBegin()
+{
+  PINIT; //Initialize if necessary.
+  TRACE('B', 0, 0, 0);
+  Eb1 = 1;
+}
+
+EventBatchCommit()
+{
+  int n, h, c;
+
+  PINIT; //Initialize if necessary.
+  TRACE('L', 0, 0, 0);
+
+  for (h = c = 0, n = Pn - 1; n > 0; n--) //Link the events held for the
+    if (P[n] == PBATCH)                   //batch into a single list, in
+    {                                     //order of event number,
+      if (T[n] < Elast)                   //except any earlier than the
+      {                                   //backend can accept.
+        enter(n);
+        continue;
+      }
+      P[n] = h;
+      h = n;
+      c += 1;
+    }
+
+  Eb1 = 0; //and pass them to the backend.
+  if (c)
+    Eq->load(h, c);
 }
 
 /*----------------------------------------------------------------------------*
@@ -425,44 +781,939 @@ WORK:  The scheduling data structures are prepared as described above.
 
 int EventNext()
 {
-  int j, n;
+  int n;
+
+  PINIT; //Initialize if necessary.
+  if (Eb1)
+    Error(738.); //Make sure no batch is being loaded.
+
+  if (Eoh < Eot)   //Take the earliest event from
+  {                 //those taken ahead, or from the
+    n = Eo[Eoh++];  //backend, if there is one, and
+    P[n] = PEMPTY;  //advance the global time.
+  }
+  else
+    n = take();
+  if (n == 0)
+  {
+    TRACE('N', 0, 0, t);
+    return 0;
+  }
+
+  En -= 1;
+  Es.dispatched += 1;
+  t = TIME(T[n]);
+  TRACE('N', n, 0, t);
+  return n;
+}
+
+/*----------------------------------------------------------------------------*
+TAKE EVENTS AHEAD
+
+These routines let the caller see a run of upcoming events before dispatching
+them, as the main loop does to dispatch every event up to the next report
+without checking the time after each, and to fetch the records of individuals
+into cache ahead of their events.
+
+'EventNextBatch' takes events from the backend, in order, into the array 'Eo',
+until it holds 'max' events earlier than 'tmax' or one that is not. The events
+stay scheduled. They are dispatched from the front of 'Eo' by 'EventNext' and
+'EventNextBefore', and 'EventAhead' names them for the caller. Since the
+backend has passed them, any event scheduled or rescheduled earlier than the
+last taken, 'Elast', joins them in 'Eo' in order, and those cancelled, moved,
+or rescheduled are changed there. The order of dispatching is therefore exactly
+as if the events had never been taken ahead, whatever the handlers do.
+
+ENTRY: (EventNextBatch) 'tmax' contains the time horizon.
+         'max' contains the greatest number of events wanted.
+       (EventNextBefore) 'tmax' contains the time horizon.
+       (EventAhead) 'i' contains a position among the events taken ahead,
+         zero for the next event to be dispatched.
+
+EXIT:  (EventNextBatch) 'EventNextBatch' contains the number of events earlier
+         than 'tmax' taken ahead, not more than 'max'. Zero means the next event
+         is not earlier than 'tmax', or no events are scheduled.
+       (EventNextBefore) As for 'EventNext' if the next event is earlier than
+         'tmax'. Otherwise 'EventNextBefore' contains zero and nothing changes.
+       (EventAhead) 'EventAhead' contains the number of the event at position
+         'i', or zero if no event is taken ahead that far.
+*/
+
+int EventNextBatch(dec tmax, int max)
+{
+  int k;
+  etime tm;
+
+  PINIT; //Initialize if necessary.
+  if (Eb1)
+    Error(738.1); //Make sure no batch is being loaded.
+
+  tm = TICK(tmax); //Take events until enough are
+  while (Eot - Eoh < max && (Eoh == Eot || T[Eo[Eot - 1]] < tm))
+    if (atake() == 0) //held or one is beyond the
+      break;          //horizon.
+
+  for (k = 0; k < max && Eoh + k < Eot && T[Eo[Eoh + k]] < tm; k++)
+    ; //Count those within it.
+  return k;
+}
+
+int EventNextBefore(dec tmax)
+{
+  PINIT; //Initialize if necessary.
+
+  if (Eoh == Eot && atake() == 0) //Make sure the next event is
+    return 0;                     //taken ahead, and dispatch it if
+  if (T[Eo[Eoh]] >= TICK(tmax))   //it is early enough.
+    return 0;
+  return EventNext();
+}
+
+int EventAhead(int i)
+{
+  return Eoh + i < Eot ? Eo[Eoh + i] : 0;
+}
+
+/*----------------------------------------------------------------------------*
+MAINTAIN EVENTS TAKEN AHEAD
+
+'atake' takes the next event from the backend and adds it at the end of 'Eo',
+returning its number, or zero if the backend is empty. 'take' takes the next
+event from the backend, discarding any cancelled with 'LAZY'. 'enter' passes an
+event to the backend, or adds it to 'Eo' in order if it is earlier than the
+backend can accept. 'afind' locates an event in 'Eo' by a binary search on its
+time, and 'aremove' removes it. 'aroom' makes room for one more event at the
+end.
+*/
+
+int atake()
+{
+  int n;
+
+  if ((n = take()) == 0)
+    return 0;
+  aroom();
+  Eo[Eot++] = n;
+  P[n] = PAHEAD;
+  return n;
+}
+
+int take()
+{
+  int n;
+
+  while ((n = Eq->next()) > 0) //Take events from the backend,
+  {                            //discarding any cancelled with
+    Elast = T[n];              //'LAZY'.
+    if (LAZY == 0 || Ed[n] == 0)
+      return n;
+    Ed[n] = 0;
+    Edn -= 1;
+    Es.dropped += 1;
+  }
+  return 0;
+}
+
+int enter(int n)
+{
+  int i, lo, hi;
+
+  if (T[n] >= Elast) //Give the event to the backend if
+  {                  //it is not earlier than those the
+    Eq->schedule(n); //backend has passed.
+    return 0;
+  }
+
+  aroom();
+  for (lo = Eoh, hi = Eot; lo < hi;) //Otherwise find the first event
+  {                                  //taken ahead that is later,
+    i = (lo + hi) / 2;
+    if (T[Eo[i]] <= T[n])
+      lo = i + 1;
+    else
+      hi = i;
+  }
+  memmove(&Eo[lo + 1], &Eo[lo], (Eot - lo) * sizeof Eo[0]); //and insert the
+  Eo[lo] = n;                                              //event before it.
+  Eot += 1;
+  P[n] = PAHEAD;
+}
+
+int afind(int n)
+{
+  int i, lo, hi;
+
+  for (lo = Eoh, hi = Eot; lo < hi;) //Find the first event with the
+  {                                  //same time, then search among
+    i = (lo + hi) / 2;               //those with that time.
+    if (T[Eo[i]] < T[n])
+      lo = i + 1;
+    else
+      hi = i;
+  }
+  for (i = lo; i < Eot && Eo[i] != n; i++)
+    ;
+  if (i >= Eot)
+    Error2(818.1, "n=", n, " ahead=", Eot - Eoh);
+  return i;
+}
+
+int aremove(int n)
+{
+  int i;
+
+  i = afind(n);
+  memmove(&Eo[i], &Eo[i + 1], (Eot - i - 1) * sizeof Eo[0]);
+  Eot -= 1;
+  P[n] = PEMPTY;
+}
 
+int aroom()
+{
+  if (Eoh == Eot) //Start again at the beginning when
+    Eoh = Eot = 0; //empty,
+  if (Eot < Eoc)
+    return 0;
+  if (Eoh > 0) //then close up space already
+  {            //dispatched, or enlarge the array.
+    memmove(Eo, &Eo[Eoh], (Eot - Eoh) * sizeof Eo[0]);
+    Eot -= Eoh;
+    Eoh = 0;
+    return 0;
+  }
+  Eoc = Eoc ? 2 * Eoc : 256;
+  if ((Eo = realloc(Eo, Eoc * sizeof Eo[0])) == 0)
+    Error1(911.3, "n=", Eoc);
+}
+
+/*----------------------------------------------------------------------------*
+DISPLAY PROFILE
+
+This routine displays the backend in use and the number of events scheduled,
+then has the backend display the distribution of events in its own structures.
+
+ENTRY: 'label' contains an optional label to be displayed with the results,
+         such as "Initial" or "Final".
+
+EXIT;  'EventProfile' contains the amount of memory allocated for the main data
+        structures.
+*/
+
+int EventProfile(char *label)
+{
   PINIT; //Initialize if necessary.
 
+  if (label == 0 || label[0] == 0)
+    label = "Bin"; //Establish a default label.
+
+  printf("%s scheduler: %s, %d events (%d taken ahead, %d cancelled but held)\n",
+         label, Eq->name, En, Eot - Eoh, Edn);
+  return Pn * (sizeof T[0] + sizeof P[0]) + Eq->profile(label);
+}
+
+/*----------------------------------------------------------------------------*
+WRITE TELEMETRY
+
+This routine writes one line of counters describing the work the scheduler has
+done since the line before, so that a series of lines taken through a long run
+shows whether the time goes to the event queue and, if so, to which part of it.
+Cancellation takes constant time in every backend, so only the number of
+cancellations is reported, not the length of any search. Counters that do not
+apply to the backend in use remain zero.
+
+ENTRY: 'fp' points to an open file. If nothing has been written to it, a
+         heading line is written first.
+       'Es' contains the counters since the last call.
+
+EXIT:  A line has been written and the counters have been cleared.
+*/
+
+int EventTelemetry(FILE *fp)
+{
+  PINIT; //Initialize if necessary.
+
+  if (ftell(fp) == 0)
+    fprintf(fp, "t\tevents\tdispatched\tscheduled\tcancelled\trescheduled"
+                "\trelisted\tsorts\tsortmean\tsortmax\tscanned\twraps"
+                "\tpromoted\trebuilds\tdropped\n");
+
+  fprintf(fp, "%.3f\t%d\t%.0f\t%.0f\t%.0f\t%.0f\t%.0f\t%.0f\t%.2f\t%.0f\t%.2f"
+              "\t%.0f\t%.0f\t%.0f\t%.0f\n",
+          t, En, Es.dispatched, Es.scheduled, Es.cancelled, Es.rescheduled,
+          Es.relisted, Es.sorts, Es.sorts ? Es.sorted / Es.sorts : 0,
+          Es.sortmax, Es.dispatched ? Es.scanned / Es.dispatched : 0,
+          Es.wraps, Es.promoted, Es.rebuilds, Es.dropped);
+  fflush(fp);
+
+  memset(&Es, 0, sizeof Es); //Start the next interval.
+}
+
+/*----------------------------------------------------------------------------*
+RECORD A SORT
+
+ENTRY: 'n' contains the number of events in a bin or bucket just sorted.
+
+EXIT:  The sort has been counted in 'Es'.
+*/
+
+int esort(int n)
+{
+  Es.sorts += 1;
+  Es.sorted += n;
+  if (n > Es.sortmax)
+    Es.sortmax = n;
+}
+
+/*----------------------------------------------------------------------------*
+RECORD EVENT TRACE
+
+These routines record every call made to the module, in order, as a series of
+binary records in a file, so that the same stream of events can be fed to the
+scheduler again without the model, as by the program in 'replay.c'. That
+separates the cost of scheduling from the cost of the model on real runs and
+gives a fixed workload against which changes to the scheduler can be compared.
+The records are described in 'schedule.h'. They are gathered in 'Er' and
+written a block at a time.
+
+'EventTrace' starts recording into a file opened for binary writing, or with
+a null pointer, writes any records remaining and stops. 'EventTraceNote' adds
+a record describing the event just dispatched, for the caller to fill in with
+its type and the identity of the individual.
+
+ENTRY: (EventTrace) 'fp' points to the trace file, or is zero.
+       (EventTraceNote) 'n' contains the number of the event dispatched.
+         'type' and 'id' contain its type and individual.
+
+EXIT:  (EventTrace) Recording has started or stopped, as requested.
+       (EventTraceNote) The record has been added if recording.
+*/
+
+int EventTrace(FILE *fp)
+{
+  if (Etf && Ern) //Write any records held for the
+    fwrite(Er, sizeof Er[0], Ern, Etf); //previous file.
+  if (Etf)
+    fflush(Etf);
+  Ern = 0;
+  Etf = fp;
+}
+
+int EventTraceNote(int n, int type, int id)
+{
+  if (Etf == 0)
+    return 0;
+  etrace('D', n, id, t);
+  Er[Ern - 1].type = type;
+}
+
+int etrace(int op, int n, int m, dec te)
+{
+  if (Ern >= ER) //Write out a full buffer.
+  {
+    if (fwrite(Er, sizeof Er[0], Ern, Etf) != Ern)
+      Error(512.1);
+    Ern = 0;
+  }
+  Er[Ern].t = te;
+  Er[Ern].n = n;
+  Er[Ern].m = m;
+  Er[Ern].op = op;
+  Er[Ern].type = 0;
+  Ern += 1;
+}
+
+/*----------------------------------------------------------------------------*
+CALENDAR QUEUE
+
+The remaining routines in this module are the entry points of the calendar
+queue backend, described at the beginning, with their subroutines. They are
+called only through the table 'Eb'.
+*/
+
+int CalInit()
+{
+  int i;
+
+  qroom(Pn); //Provide a bin for each event
+  for (i = 0; i < Qm; i++) //and empty them.
+    Q[i] = 0;
+  for (i = 0; i <= FN; i++)
+    F[i] = 0;
+  vacateall();
+
+  size(Qm, TW * TPY);
+  Qi = 0;
+  Qo = 1;
+  Qe = 0;
+  Qf = 0;
+  Qv = 0;
+  Qc = 0;
+  Qd = 0;
+  Qg = 0;
+  Qt0 = 0;
+  Qt1 = Qw;
+  Qtl = 0;
+}
+
+int CalStart(etime t0)
+{
+#if TICKS
+  Qt0 = t0; //Set the time boundaries exactly,
+#else       //or leave room for rounding errors.
+  Qt0 = t0 - (Qw / Qn) / 2;
+#endif
+  Qt1 = Qt0 + Qw;
+  Qtl = t0;
+}
+
+int CalSchedule(int n)
+{
+  link1(n); //Place the event in a bin or in
+  Qe += 1;  //the far tier and increment the
+} //number of events.
+
+int CalCancel(int n)
+{
+  int i;
+
+  if (K[n] < 0) //Events in the far tier are
+  {             //removed from their lists.
+    cancelf(n);
+    Qe -= 1;
+    return 0;
+  }
+
+  i = K[n]; //Otherwise unlink the event from
+  if (i >= Qn || Qe <= 0) //the bin recorded for it.
+    Error2(819., "n=", n, " bin=", i);
+  if (P[n] > 0)
+    U[P[n]] = U[n];
+  if (U[n] > 0)
+    P[U[n]] = P[n];
+  else if ((Q[i] = P[n]) == 0)
+    vacate(i);
+  P[n] = PEMPTY;
+  Qe -= 1;
+}
+
+int CalMove(int n, int m)
+{
+  P[n] = P[m];  //Take over the links of the old
+  U[n] = U[m];  //number and point its neighbours,
+  K[n] = K[m];  //or the head of its list, at the
+  if (P[n] > 0) //new number.
+    U[P[n]] = n;
+  if (U[n] > 0)
+    P[U[n]] = n;
+  else if (K[n] >= 0)
+    Q[K[n]] = n;
+  else
+    F[KF(K[n])] = n;
+  P[m] = PEMPTY;
+}
+
+int CalReschedule(int n, etime te)
+{
+  int k;
+
+  k = place(te);  //If the event stays in the same
+  if (k == K[n])  //list only its time changes,
+  {               //though the list must be resorted
+    if (k == Qi)  //if it is being dispatched, and
+      Qo = 0;     //the final list may gain or lose
+    if (k == KF(FN)) //an infinite time.
+      Qv += (te >= TINF) - (T[n] >= TINF);
+    T[n] = te;
+    return 0;
+  }
+
+  CalCancel(n); //Otherwise move it.
+  T[n] = te;
+  CalSchedule(n);
+  Es.relisted += 1;
+}
+
+int CalLoad(int h, int c)
+{
+  int j, jn;
+
+  for (j = h; j > 0; j = jn) //Link each event directly into its
+  {                          //bin or far-tier list. Only the
+    jn = P[j];               //bin being dispatched is sorted,
+    link1(j);                //when it is reached.
+  }
+  Qe += c;
+}
+
+/*----------------------------------------------------------------------------*
+CALENDAR QUEUE: LOCATE NEXT EVENT
+
+ENTRY: 'T' contains the time of the next event for every event scheduled.
+       The bin structure is properly initialized.
+
+EXIT:  'CalNext' contains the number of the next event, removed from the bins.
+         If zero, no events are scheduled.
+
+WORK:  The scheduling data structures are prepared as described above.
+*/
+
+int CalNext()
+{
+  int j, k;
+
+  if (QTUNE && Qd >= QSAMPLE) //Periodically check the bins
+    tune();                   //against recent events.
+
   while (Qe > 0)
   {
+    if (Qe == Qv) //If only events with infinite
+    {             //times remain, dispatch them in
+      j = F[FN];  //turn; no cycle will reach them.
+      cancelf(j);
+      Qe -= 1;
+      return j;
+    }
+    if (Qe == Qf) //If all events are in the far
+      Qi = Qn;    //tier there is nothing to sweep.
+
     for (; Qi < Qn; Qo = 0, Qi++) //Advance to the next non-empty
-    {
+    {                             //bin, using the bitmap to pass
+      if (Q[Qi] == 0)             //over empty bins.
+      {
+        k = nextbin(Qi);
+        Es.scanned += k - Qi;
+        Qi = k;
+        Qo = 0;
+        if (Qi >= Qn)
+          break;
+      }
       j = Q[Qi];
-      if (j == 0)
-        continue; //bin.
 
       if (Qo == 0) //Sort the bin if it may be
-      {
-        j = Q[Qi] = sort(P, j, 0);
+      {            //necessary, and restore its
+        j = Q[Qi] = tsort(P, j, &Qsw); //back links.
+        esort(relink(j));
         Qo = 1;
-      } //necessary.
+      }
 
       if (T[j] < Qt1) //If the event belongs to this
       {
         if (P[j] == PEMPTY)
           Error(820.1); //pass, remove it from the list,
         Q[Qi] = P[j];   //decrement the number of events,
+        if (P[j] > 0)
+          U[P[j]] = 0;
+        else
+          vacate(Qi);
         P[j] = PEMPTY;
-        Qe -= 1; //advance the global time, and
-        t = T[j];
+        Qe -= 1;
+        Qd += 1; //record the interval for tuning,
+        Qg += T[j] - Qtl;
+        Qtl = T[j];
         return j;
       }
     } //return the event's index.
 
     Qi = 0;
+    Qo = 0;
     Qt0 += Qw;
-    Qt1 = Qt0 + Qw;
-  } //Circle back to the first bin.
+    Qt1 = Qt0 + Qw; //Circle back to the first bin and
+    Qc += 1;        //bring in the events that now fall
+    Es.wraps += 1;  //within the cycle.
+    advance();
+  }
 
   return 0; //Signal completion of all events.
 }
 
+/*----------------------------------------------------------------------------*
+PLACE EVENT
+
+This routine places an event either in its time bin, if it falls within the
+present cycle, or in the far-tier list for the cycle in which it falls.
+
+ENTRY: 'n' contains the number of an event not presently in any list.
+       'T[n]' contains the time of the event.
+
+EXIT:  The event has been linked into a bin or a far-tier list.
+       'K[n]' records where it was placed.
+*/
+
+int link1(int n)
+{
+  int i, b;
+
+  i = place(T[n]); //Determine the list for the event.
+  if (i >= 0)
+  {
+    if (i == Qi) //Mark the bin for sorting if
+      Qo = 0;    //needed.
+
+    P[n] = Q[i]; //Add the event to the front of
+    U[n] = 0;    //the list for that bin.
+    if (Q[i])
+      U[Q[i]] = n;
+    else
+      occupy(i);
+    Q[i] = n;
+    K[n] = i;
+    return 0;
+  }
+
+  b = KF(i);   //Otherwise add it to the front of
+  P[n] = F[b]; //the far-tier list for its cycle,
+  U[n] = 0;    //or to the final list if it is
+  if (F[b])    //beyond all cycles held.
+    U[F[b]] = n;
+  F[b] = n;
+  K[n] = i;
+  Qf += 1;
+  if (T[n] >= TINF)
+    Qv += 1;
+}
+
+/*----------------------------------------------------------------------------*
+LOCATE LIST FOR A TIME
+
+ENTRY: 'te' contains the time of an event, not earlier than the present cycle.
+
+EXIT:  'place' contains the value for 'K' of the list that should hold the
+         event---the number of its time bin if it falls in the present cycle,
+         otherwise 'KF' of its far-tier list.
+*/
+
+int place(etime te)
+{
+#if TICKS
+  etime d, c;
+
+  d = te - Qt0;       //Determine how many cycles ahead
+  c = d >> (Qs + Ql); //the event lies. If it is in this
+  if (c < 1)          //cycle, the bin is given by the
+    return d >> Qs & (Qn - 1); //next bits of the time.
+
+  return KF(c < FN ? (Qc + (int)c) % FN : FN);
+#else
+  int i;
+  dec tr;
+
+  tr = (te - Qt0) / Qw; //Determine how many cycles ahead
+  if (tr < 1)           //the event lies. If it is in this
+  {                     //cycle, convert the time to a bin
+    tr -= (int)tr;      //number.
+    i = tr * Qn;
+    return i;
+  }
+
+  return KF(tr < FN ? (Qc + (int)tr) % FN : FN);
+#endif
+}
+
+/*----------------------------------------------------------------------------*
+SET SIZE OF BINS
+
+ENTRY: 'n' contains the number of bins wanted, not greater than 'Qm'.
+       'w' contains the width wanted for the cycle, in units of 'etime'.
+
+EXIT:  'Qn' and 'Qw' have been set. With 'TICKS', 'Qn' is the greatest power
+         of two not above 'n', and 'Qw' is 'Qn' times the power of two nearest
+         to the width of a bin, with 'Ql' and 'Qs' the corresponding shifts.
+*/
+
+int size(int n, dec w)
+{
+#if TICKS
+  for (Ql = 0; 2 << Ql <= n; Ql++)
+    ;
+  Qn = 1 << Ql;
+  for (Qs = 0; w / Qn > 1.5 * ((etime)1 << Qs) && Qs < 62 - Ql; Qs++)
+    ;
+  Qw = (etime)1 << (Qs + Ql);
+#else
+  Qn = n;
+  Qw = w;
+#endif
+}
+
+/*----------------------------------------------------------------------------*
+RESTORE BACK LINKS
+
+ENTRY: 'j' indexes the first event in a bin whose forward links have just been
+         reordered by 'tsort'.
+
+EXIT:  The backward links 'U' of the bin agree with the forward links.
+       'relink' contains the number of events in the bin.
+*/
+
+int relink(int j)
+{
+  int jp, n;
+
+  for (jp = n = 0; j > 0; jp = j, j = P[j], n++)
+    U[j] = jp;
+  return n;
+}
+
+/*----------------------------------------------------------------------------*
+PROVIDE MORE BINS
+
+ENTRY: 'n' contains the number of bins wanted.
+       Every bin from 'Qn' on is empty.
+
+EXIT:  'Q' holds at least 'n' bins, those added empty, and the bitmap covers
+         them. The bitmap must be cleared by 'vacateall' if it was enlarged.
+*/
+
+int qroom(int n)
+{
+  int i, m;
+
+  if (n <= Qm)
+    return 0;
+
+  m = Qm; //Enlarge the bins and each level
+  Qm = n; //of the bitmap in proportion.
+  Q = realloc(Q, Qm * sizeof Q[0]);
+  B1 = realloc(B1, N1 * sizeof B1[0]);
+  B2 = realloc(B2, N2 * sizeof B2[0]);
+  B3 = realloc(B3, N3 * sizeof B3[0]);
+  if (Q == 0 || B1 == 0 || B2 == 0 || B3 == 0)
+    Error1(911.5, "n=", n); //Make sure the storage was found.
+
+  for (i = m; i < Qm; i++)
+    Q[i] = 0;
+}
+
+/*----------------------------------------------------------------------------*
+MAINTAIN OCCUPANCY BITMAP
+
+'occupy' marks bin 'i' non-empty, 'vacate' marks it empty, and 'vacateall'
+marks all bins empty. 'nextbin' locates the first non-empty bin at or after bin
+'i', returning 'Qn' if there is none. Each level is consulted only when the
+level beneath has nothing more in the present word.
+*/
+
+int occupy(int i)
+{
+  B1[i >> 6] |= 1ULL << (i & 63);
+  B2[i >> 12] |= 1ULL << (i >> 6 & 63);
+  B3[i >> 18] |= 1ULL << (i >> 12 & 63);
+}
+
+int vacate(int i)
+{
+  if (B1[i >> 6] &= ~(1ULL << (i & 63)))
+    return 0;
+  if (B2[i >> 12] &= ~(1ULL << (i >> 6 & 63)))
+    return 0;
+  B3[i >> 18] &= ~(1ULL << (i >> 12 & 63));
+}
+
+int vacateall()
+{
+  int i;
+
+  for (i = 0; i < N1; i++)
+    B1[i] = 0;
+  for (i = 0; i < N2; i++)
+    B2[i] = 0;
+  for (i = 0; i < N3; i++)
+    B3[i] = 0;
+}
+
+int nextbin(int i)
+{
+  int k;
+  word m;
+
+  k = i >> 6; //Check the rest of this word of
+  m = B1[k] & ~0ULL << (i & 63); //bins.
+  if (m)
+    return k << 6 | CTZ(m);
+
+  i = k + 1; //Then the rest of this group of
+  k = i >> 6; //words.
+  m = B2[k] & ~0ULL << (i & 63);
+  if (m == 0)
+  {
+    i = k + 1; //Then the groups of groups, in
+    k = i >> 6; //turn.
+    m = B3[k] & ~0ULL << (i & 63);
+    while (m == 0)
+      if (++k >= N3)
+        return Qn;
+      else
+        m = B3[k];
+    k = k << 6 | CTZ(m); //Descend to the group,
+    m = B2[k];
+  }
+  k = k << 6 | CTZ(m); //to the word, and to the bin.
+  return k << 6 | CTZ(B1[k]);
+}
+
+/*----------------------------------------------------------------------------*
+REMOVE EVENT FROM FAR TIER
+
+ENTRY: 'n' contains the number of an event held in a far-tier list.
+       'K[n]' identifies the list.
+
+EXIT:  The event has been unlinked and 'P[n]' is marked empty.
+*/
+
+int cancelf(int n)
+{
+  if (P[n] > 0)
+    U[P[n]] = U[n]; //Close the gap in the doubly-linked
+  if (U[n] > 0)     //list, mending the head of the
+    P[U[n]] = P[n]; //list if necessary.
+  else
+    F[KF(K[n])] = P[n];
+
+  P[n] = PEMPTY;
+  Qf -= 1;
+  if (T[n] >= TINF)
+    Qv -= 1;
+  if (Qf < 0)
+    Error2(819., "n=", n, " far=", KF(K[n]));
+}
+
+/*
+Note: An event is cancelled from the bin recorded in 'K[n]' when it was placed,
+never from a bin recomputed from 'T[n]'. Two bins are separated by a
+knife-edge, and what is calculated one time as 1.0 may be calculated in a
+slightly different manner as 0.999999999999999. Earlier versions therefore
+searched the adjacent bins when an event was not found where expected.
+Recording the bin removes both the search and the rounding problem.
+*/
+
+/*----------------------------------------------------------------------------*
+ADVANCE THE FAR TIER
+
+This routine is called each time a cycle completes. It moves every event in the
+far-tier list for the new cycle into the bins, then moves any events in the
+final list that are now within 'FN' cycles into their proper lists.
+
+ENTRY: 'Qt0' and 'Qc' have just been advanced to the new cycle.
+
+EXIT:  The far-tier list for the new cycle is empty and its events are in bins.
+       The final list holds only events still beyond 'FN' cycles.
+*/
+
+int advance()
+{
+  int j, jn;
+
+  for (j = F[Qc % FN]; j > 0; j = jn) //Move the list for this cycle
+  {                                   //into the bins. The order of
+    jn = P[j];                        //the list does not matter,
+    cancelf(j);                       //since bins are sorted when
+    link1(j);                         //they are reached.
+    Es.promoted += 1;
+  }
+
+  for (j = F[FN]; j > 0; j = jn) //Check the final list for events
+  {                              //now within range.
+    jn = P[j];
+    if ((T[j] - Qt0) / Qw < FN)
+    {
+      cancelf(j);
+      link1(j);
+      Es.promoted += 1;
+    }
+  }
+}
+
+/*----------------------------------------------------------------------------*
+TUNE THE BINS
+
+This routine compares the number and width of the bins with those suggested by
+the present number of events and the mean interval between recently dispatched
+events, and rebuilds the bins if they are far out of line.
+
+ENTRY: 'Qd' contains the number of events dispatched since the last check.
+       'Qg' contains the sum of the intervals between them.
+       't' contains the time of the last event dispatched.
+
+EXIT:  'Qd' and 'Qg' are cleared.
+       'Qn' and 'Qw' are within a factor of two of their suggested values,
+         and all events have been relinked if they were not.
+*/
+
+int tune()
+{
+  int n;
+  dec g, w;
+
+  g = Qd ? Qg / Qd : 0; //Compute the mean interval and
+  Qd = 0;               //clear the accumulators.
+  Qg = 0;
+  if (Qe == 0 || g <= 0)
+    return 0;
+
+  n = Qe < QNMIN ? QNMIN : Qe > Pn ? Pn : Qe; //Suggest one bin per event and
+  w = n * g * QB;                             //the corresponding cycle width.
+
+  if (n < 2 * Qn && 2 * n > Qn && w < 2 * Qw && 2 * w > Qw)
+    return 0; //Leave the bins if close enough.
+
+  rebuild(n, w);
+  return 1;
+}
+
+/*----------------------------------------------------------------------------*
+REBUILD THE BINS
+
+ENTRY: 'n' contains the new number of bins, not greater than 'Pn'.
+       'w' contains the new width of the cycle.
+       't' contains the present time. No event is earlier than 't'.
+
+EXIT:  'Qn' and 'Qw' hold the new values and the cycle starts at 't'.
+       All events have been relinked into the new bins and far-tier lists.
+*/
+
+int rebuild(int n, dec w)
+{
+  int i, j, jn, h;
+
+  for (h = i = 0; i < Qn; i++) //Gather all events from the bins
+  {                            //and the far tier into a single
+    for (j = Q[i]; j > 0; j = jn) //list, leaving them empty.
+    {
+      jn = P[j];
+      P[j] = h;
+      h = j;
+    }
+    Q[i] = 0;
+  }
+  for (i = 0; i <= FN; i++)
+  {
+    for (j = F[i]; j > 0; j = jn)
+    {
+      jn = P[j];
+      P[j] = h;
+      h = j;
+    }
+    F[i] = 0;
+  }
+  qroom(n); //Provide more bins if necessary
+  vacateall(); //and mark all empty.
+
+  size(n, w);
+  Es.rebuilds += 1;
+  CalStart(Qtl); //Start the new cycle at the
+  Qi = 0;        //present time.
+  Qo = 0;
+  Qc = 0;
+  Qf = 0;
+  Qv = 0;
+
+  for (j = h; j > 0; j = jn) //Relink every event in its new
+  {                          //place.
+    jn = P[j];
+    link1(j);
+  }
+}
+
 /*
 NOTE: It is important to sort the active bin, as is done here. At first thought,
 it might simpler and faster just to exhaustively searched the bin each time,
@@ -473,7 +1724,7 @@ $n^2/2$, and the latter would be prohibitive.
 */
 
 /*----------------------------------------------------------------------------*
-DISPLAY PROFILE
+CALENDAR QUEUE: DISPLAY PROFILE
 
 This routine displays the distribution of schedule events---how frequently 0, 1,
 2, 3, ... events occur in bins, and compares it with a Poisson distribution,
@@ -483,27 +1734,24 @@ ENTRY: 'label' contains an optional label to be displayed with the results,
          such as "Initial" or "Final".
        The bins have been initialized.
 
-EXIT;  'EventProfile' contains the amount of memory allocated for the main data
-        structures.
+EXIT;  'CalProfile' contains the amount of memory allocated for the bins and
+        far tier.
 */
 
 #define PROF 1001
 
-int EventProfile(char *label)
+int CalProfile(char *label)
 {
   int i, j, n, imax, prof[PROF];
   dec nexp, lambda, eml, ln, nf;
 
-  if (label == 0 || label[0] == 0)
-    label = "Bin"; //Establish a default label.
-
   for (i = 0; i < PROF; i++)
     prof[i] = 0; //Clear the profile array.
 
   for (i = 0; i < Qn; i++) //Count the number of bins that
   {
     for (j = Q[i], n = 0; j > 0; j = P[j], n++) //have no entries, one entry, two
-      if (j < 1 || j >= PN || n > PN)           //entries, etc.
+      if (j < 1 || j >= Pn || n > Pn)           //entries, etc.
         Error1(820.2, "j=", j);
     if (n > PROF - 1)
       n = PROF - 1;
@@ -514,12 +1762,12 @@ int EventProfile(char *label)
     if (prof[i])
       imax = i; //in any bin.
 
-  lambda = (dec)Qe / Qn; //Compute the parameters for the
+  lambda = (dec)(Qe - Qf) / Qn; //Compute the parameters for the
   eml = exp(-lambda);
   ln = nf = 1; //Poisson distribution.
 
   printf("%s distribution of %d events:\n", //Display heading lines.
-         label, Qe);
+         label, Qe - Qf);
   printf("   N   Observed   Expected\n");
 
   for (i = 0; i <= imax; i++) //Display the distribution of bin
@@ -532,32 +1780,32 @@ int EventProfile(char *label)
     nf *= i + 1;
   }
 
-  printf("\n");                          //Leave a blank line and return
-  return sizeof Q + sizeof T + sizeof P; //with the size of the main data
-} //structure.
-
-/*----------------------------------------------------------------------------*
-DETERMINE SORTING ORDER
-
-This routine is called from 'sort' when it needs to have two elements compared.
-
-ENTRY: 'p' indexes list element one.
-       'q' indexes list element two.
-
-EXIT:  'order' contains a status code.
-        '<0' Element one is less than element two.
-        '=0' Element one is equal to element two.
-        '>0' Element one is greater than element two.
-*/
-
-int order(int p, int q)
-{
-  dec w;
+  for (i = 0, n = 0; i < Qn; i++) //Count the events in the bins that
+    for (j = Q[i]; j > 0; j = P[j])  //belong to later cycles and will
+      if (T[j] >= Qt1)               //be passed over by this sweep.
+        n++;
+  printf("Bins: %d, cycle width %g\n", Qn, Qw / TPY);
+  printf("Tiers: %d in bins (%d beyond this cycle), %d in far tier\n",
+         Qe - Qf, n, Qf);
+
+  printf("   Cycle   Events\n");
+  for (i = 1; i <= FN; i++) //Display the number of events held
+  {                         //for each future cycle.
+    for (j = F[i < FN ? (Qc + i) % FN : FN], n = 0; j > 0; j = P[j])
+      n++;
+    if (n)
+      printf("%7d%c%8d\n", i, i < FN ? ' ' : '+', n);
+  }
 
-  w = T[p] - T[q];
-  return w < 0 ? -1 : w > 0 ? 1 : 0;
+  printf("\n"); //Leave a blank line and return
+  return Qm * sizeof Q[0] + Pn * (sizeof U[0] + sizeof K[0]) + //with the size
+         sizeof F + (N1 + N2 + N3) * sizeof(word);              //of the bins.
 }
 
+#include "schedules.c" //Sorting by time.
+#include "scheduleh.c" //Alternative backends.
+#include "schedulel.c"
+
 /* (C) CLARENCE LEHMAN, UNIVERSITY OF MINNESOTA, AUGUST 2009.
 
 [To become open-source software as part of the modelling package.]
@@ -573,4 +1821,47 @@ Modifications
 3. Comments and names updated for general distribution, April 2011 [CLL].
 
 4. 'EventInit' added for serial reusability, May 2011 [CLL].
+
+5. Far tier added to hold events beyond the present cycle, so that long-range
+   events such as deaths are not passed over on every sweep of the bins.
+
+6. Number and width of bins tuned during the run, following Brown.
+
+7. Calendar queue separated behind a table of backends, with an indexed 4-ary
+   heap and a ladder queue as alternatives, selected at compile time or run
+   time.
+
+8. Bins doubly linked and the bin of each event recorded, so that cancellation
+   takes constant time without searching adjacent bins for rounding errors.
+
+9. 'EventMove' and 'EventReschedule' added, changing the number or time of an
+   event in place instead of cancelling and scheduling it again. 'EventRenumber'
+   retained as another name for 'EventMove'.
+
+10. 'EventBatchBegin' and 'EventBatchCommit' added to load many events at once.
+
+11. Occupancy bitmap added so that dispatching passes over empty bins quickly.
+
+12. Option 'TICKS' added to hold times as integer ticks, with bins selected by
+    shifting and masking.
+
+13. Bins sorted by 'tsort', by insertion or radix on the event times, in place
+    of the general merge sort.
+
+14. 'EventTelemetry' added to write counters of the scheduler's work at each
+    report.
+
+15. 'EventTrace' and 'EventTraceNote' added to record every call in a binary
+    file for replay.
+
+16. 'EventNextBatch', 'EventNextBefore', and 'EventAhead' added so that events
+    can be dispatched in runs up to a time horizon.
+
+17. Option 'LAZY' added to leave cancelled events with the backend until they
+    are scheduled again or reach the front.
+
+18. Arrays indexed by event number or bin allocated at run time and enlarged as
+    needed, rather than sized by 'INDIV'. 'EventCapacity' added.
+
+19. Option 'TIME32' added to hold the times in 'T' in four bytes.
 */
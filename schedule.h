@@ -0,0 +1,172 @@
+/*----------------------------------------------------------------------------*
+SCHEDULER BACKENDS
+
+The rest of the program reaches the event scheduler only through the routines
+'EventSchedule', 'EventCancel', 'EventMove', 'EventReschedule', 'EventNext',
+'EventNextBatch', 'EventBatchBegin', 'EventBatchCommit', and 'EventStartTime'
+in 'schedule.c'. Those routines check their arguments, record event times in
+'T[n]', keep the count of scheduled events, and hold any events taken ahead of
+the backend by 'EventNextBatch'. What remains---holding the events in order---
+is done by a backend. Several backends are
+available so that they can be compared on the same stream of events without
+changes to the model:
+
+  0 Calendar queue ('schedule.c'), O(1) for well-spread events.
+  1 Indexed 4-ary heap ('scheduleh.c'), O(log n) regardless of distribution.
+  2 Ladder queue ('schedulel.c'), O(1) amortized, adapts to skewed times.
+
+The backend is chosen by defining 'SCHEDULER' when 'schedule.c' is compiled, or
+at run time by calling 'EventBackend' before any events are scheduled (the model
+does this from the command-line parameter 'scheduler=N').
+
+Events with equal times are dispatched in the same order by every backend, the
+one scheduled or rescheduled last first, so that a run or a trace replayed does
+not depend on the backend chosen. The one exception is the calendar queue's
+final far-tier list, beyond 'FN' cycles ahead, whose events tie in the order
+they were scheduled.
+
+Times passed to and from the module are in years. Inside the module they are
+held in the type 'etime', which is the same as 'dec' unless 'TICKS' is set when
+'schedule.c' is compiled. In that case each time is held as a 64-bit integer
+count of 'TPY' ticks per year since the starting time, with 'TINF' standing for
+an infinite time. Ticks are ordered exactly, and the calendar queue then uses
+a power of two for the number of bins and for the width of each, so that a bin
+is selected by a shift and a mask, with no rounding at the edges of bins. Times
+are converted on the way in and out, rounding to the nearest tick so that the
+current time 't' converts back to its own tick, and the rest of the program
+continues to work in calendar years.
+
+If 'TIME32' is set (see 'common.h'), 'TICKS' is set with it and each time in
+'T[n]' is held in four bytes as an unsigned count of ticks ('estore'), about two
+seconds each, which covers 256 years from the starting time. Later times are
+held as infinite. Arithmetic on times is still done in 'etime'.
+
+Each backend supplies the entry points below. All backends share the arrays
+'T[n]', the time of event 'n', and 'P[n]', which must equal 'PEMPTY' exactly
+when event 'n' is not held by the backend. Other than that each backend may use
+'P[n]' as it wishes.
+
+init     ENTRY: No significant conditions.
+         EXIT:  The backend holds no events.
+
+start    ENTRY: 't0' contains the time at or before which the first event will
+                occur. The backend holds no events.
+         EXIT:  The backend is positioned to start at 't0'.
+
+schedule ENTRY: 'n' contains an event not held by the backend, 'P[n]' is
+                'PEMPTY', and 'T[n]' contains its time, not earlier than 't'.
+         EXIT:  The event is held by the backend.
+
+cancel   ENTRY: 'n' contains an event held by the backend.
+         EXIT:  The event is no longer held and 'P[n]' is 'PEMPTY'.
+
+move     ENTRY: 'm' contains an event held by the backend. 'n' contains an event
+                not held, with 'P[n]' equal to 'PEMPTY'. 'T[n]' equals 'T[m]'.
+         EXIT:  Event 'm' is held in place as event 'n', and 'P[m]' is
+                'PEMPTY'.
+
+reschedule
+         ENTRY: 'n' contains an event held by the backend, with its present
+                time in 'T[n]'. 'te' contains its new time, not earlier than
+                't'.
+         EXIT:  The event is held at time 'te', which is recorded in 'T[n]'.
+                If the event stays in the same place nothing else is changed.
+
+load     ENTRY: 'h' indexes the first of 'c' events not held by the backend,
+                linked through 'P' and ending with zero. 'T' contains their
+                times.
+         EXIT:  All the events are held by the backend.
+
+next     ENTRY: No significant conditions.
+         EXIT:  The earliest event has been removed and its number returned,
+                with 'P[n]' set to 'PEMPTY'. If zero, no events are held.
+
+profile  ENTRY: 'label' contains a label for the display.
+         EXIT:  Statistics on the backend's structures have been displayed, and
+                'profile' returns the memory they occupy beyond 'T' and 'P'.
+*/
+
+#ifndef TICKS
+#define TICKS 0 //Set to hold times as integer ticks.
+#endif
+#if TIME32 && !TICKS
+#undef TICKS
+#define TICKS 1 //(Four-byte times are held as ticks.)
+#endif
+
+#if TIME32
+typedef long long etime;     //Time within the module, in ticks,
+typedef unsigned int estore; //and as held in 'T'.
+#define TPY 16777216.        //Ticks per year (about 2 s each).
+#define TINF 0xffffffffLL    //Tick value for infinite times.
+#elif TICKS
+typedef long long etime;          //Time within the module, in ticks.
+typedef etime estore;
+#define TPY 4294967296.           //Ticks per year (about 7 ms each).
+#define TINF 0x7fffffffffffffffLL //Tick value for infinite times.
+#else
+typedef dec etime;    //Time within the module, in years.
+typedef etime estore;
+#define TPY 1.        //Units per year.
+#define TINF HUGE_VAL //Infinite time.
+#endif
+
+struct Etrace //Record of one call, written by 'EventTrace'.
+{
+  dec t;      //Time given or returned, in years.
+  int n;      //Event number.
+  int m;      //Old number ('M'), or individual's identity ('D'), or
+              //the number of a clock from 'CLOCK0' ('D' of 'pClock').
+  short op;   //'I' EventStartTime, 'S' EventSchedule, 'C' EventCancel,
+              //'M' EventMove, 'R' EventReschedule, 'B' EventBatchBegin,
+              //'L' EventBatchCommit, 'N' EventNext (zero 'n' if empty),
+              //'D' event dispatched by the model (see 'EventTraceNote').
+  short type; //Type of the event dispatched ('D'), 'pClock' for the
+              //tick of a clock, which replays no individual's event.
+};
+
+struct Estats //Counters kept since the last telemetry line.
+{
+  dec dispatched;  //Events dispatched.
+  dec scheduled;   //Events scheduled.
+  dec cancelled;   //Events cancelled.
+  dec rescheduled; //Events rescheduled.
+  dec relisted;    //Those of them that changed lists.
+  dec sorts;       //Bins or buckets sorted.
+  dec sorted;      //Events in them.
+  dec sortmax;     //Events in the largest of them.
+  dec scanned;     //Empty bins passed over.
+  dec wraps;       //Cycles completed.
+  dec promoted;    //Events brought into the bins from a far tier.
+  dec rebuilds;    //Times the bins were rebuilt.
+  dec dropped;     //Events cancelled with 'LAZY' discarded at the front.
+};
+
+struct Sortw //Working storage for 'tsort'.
+{
+  int n;                    //Number of elements each array holds.
+  int *x[2];                //Event numbers, and a second array
+  unsigned long long *k[2]; //for each pass of the sort, with
+};                          //their keys.
+
+struct Backend
+{
+  char *name;                    //Name for reports.
+  int (*init)();                 //Clear all structures.
+  int (*start)(etime);           //Position to start at a given time.
+  int (*schedule)(int);          //Add an event whose time is in 'T'.
+  int (*cancel)(int);            //Remove a scheduled event.
+  int (*move)(int, int);         //Renumber a scheduled event in place.
+  int (*reschedule)(int, etime); //Change the time of a scheduled event.
+  int (*load)(int, int);         //Add a list of events in one pass.
+  int (*next)();                 //Remove and return the earliest event.
+  int (*profile)(char *);        //Display statistics and return size.
+};
+
+int CalInit(), CalStart(etime), CalSchedule(int), CalCancel(int), CalMove(int, int),
+    CalReschedule(int, etime), CalLoad(int, int), CalNext(), CalProfile(char *);
+int HeapInit(), HeapStart(etime), HeapSchedule(int), HeapCancel(int),
+    HeapMove(int, int), HeapReschedule(int, etime), HeapLoad(int, int), HeapNext(),
+    HeapProfile(char *);
+int LadInit(), LadStart(etime), LadSchedule(int), LadCancel(int), LadMove(int, int),
+    LadReschedule(int, etime), LadLoad(int, int), LadNext(), LadProfile(char *);
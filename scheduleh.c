@@ -0,0 +1,226 @@
+/*----------------------------------------------------------------------------*
+INDEXED 4-ARY HEAP
+
+This backend holds scheduled events in an implicit heap 'Z[1]', 'Z[2]', ...,
+'Z[Zn]', in which each element is no later than any of its 'HD' children.
+Element 'i' has children 'HD*(i-1)+2' through 'HD*(i-1)+HD+1' and parent
+'(i-2)/HD+1'. The earliest event is always at 'Z[1]'.
+
+The heap is indexed: 'P[n]' holds the position of event 'n' within 'Z', so that
+an event can be cancelled directly, by moving the last element into its place
+and sifting that element up or down as needed. Every operation is O(log n),
+whatever the distribution of event times. A branching factor of four rather
+than two halves the depth of the heap and keeps the children of each element
+together in memory, which more than pays for the extra comparisons.
+
+A heap by itself leaves events with equal times in no particular order. So that
+they are dispatched last in, first out, as by the other backends (see
+'schedule.h'), each event is numbered in 'U[n]' as it enters the heap, and ties
+go to the higher number. The numbers are compared by their difference, so they
+may wrap around.
+
+This file is included in 'schedule.c' and shares its arrays 'T', 'P', and 'U',
+which the other backends use for back links.
+*/
+
+#define HD 4 //Number of children of each element.
+#define HB(a, b) (T[a] < T[b] || (T[a] == T[b] && (int)((unsigned)U[a] - U[b]) > 0))
+                 //Event 'a' comes before event 'b'.
+
+static int *Z; //Heap of event numbers, starting at 'Z[1]'.
+static int Zn; //Number of events in the heap.
+static int Zm; //Number of elements allocated for 'Z'.
+static unsigned Zq; //Number of events entered, to order ties.
+
+int HeapInit()
+{
+  Zn = 0;
+  Zq = 0;
+}
+
+int HeapStart(etime t0)
+{
+  return 0; //Heap positions do not depend on time.
+}
+
+int HeapSchedule(int n)
+{
+  if (Zn + 1 >= Zm)
+    hroom(Zn + 2);
+  Zn += 1;     //Place the event at the end of
+  Z[Zn] = n;   //the heap, ahead of others with
+  P[n] = Zn;   //the same time, and move it up to
+  U[n] = Zq++; //its proper place.
+  siftup(Zn);
+}
+
+int HeapCancel(int n)
+{
+  int i, m;
+
+  i = P[n];
+  if (i < 1 || i > Zn || Z[i] != n)
+    Error2(819., "n=", n, " heap=", i);
+
+  P[n] = PEMPTY; //Remove the event and fill its
+  m = Z[Zn];     //place with the last element,
+  Zn -= 1;       //which may belong either higher
+  if (i > Zn)    //or lower.
+    return 0;
+
+  Z[i] = m;
+  P[m] = i;
+  if (i > 1 && HB(m, Z[(i - 2) / HD + 1]))
+    siftup(i);
+  else
+    siftdown(i);
+}
+
+int HeapMove(int n, int m)
+{
+  P[n] = P[m]; //Put the new number in the old
+  U[n] = U[m]; //number's place.
+  Z[P[n]] = n;
+  P[m] = PEMPTY;
+}
+
+int HeapReschedule(int n, etime te)
+{
+  int i;
+
+  i = P[n];    //Record the new time, ahead of
+  T[n] = te;   //others with the same time, and
+  U[n] = Zq++; //move the event up or down.
+  if (i > 1 && HB(n, Z[(i - 2) / HD + 1]))
+    siftup(i);
+  else
+    siftdown(i);
+}
+
+int HeapLoad(int h, int c)
+{
+  int j, i;
+
+  hroom(Zn + c + 1);
+  for (j = h; j > 0; j = P[j]) //Append the events to the heap in
+  {                            //the order of the list, which
+    Z[++Zn] = j;               //breaks their ties,
+    U[j] = Zq++;
+  }
+
+  for (i = Zn; i >= 1; i--) //record their positions, and then
+    P[Z[i]] = i;            //restore heap order from the
+  for (i = (Zn - 2) / HD + 1; i >= 1; i--) //bottom up, which takes linear
+    siftdown(i);                           //time.
+}
+
+int HeapNext()
+{
+  int n;
+
+  if (Zn == 0)
+    return 0; //Signal completion of all events.
+
+  n = Z[1];      //Take the event at the root and
+  HeapCancel(n); //repair the heap below it.
+  return n;
+}
+
+/*----------------------------------------------------------------------------*
+RESTORE HEAP ORDER
+
+ENTRY: 'i' contains a position in the heap whose element may be out of order
+         with its parent ('siftup') or with its children ('siftdown'), by
+         time and then by order of entry in 'U'.
+       The heap is otherwise in order.
+
+EXIT:  The element has been moved to its proper place and the heap is in order.
+       'P' records the new position of every element moved.
+*/
+
+int siftup(int i)
+{
+  int n, p;
+
+  n = Z[i];
+  while (i > 1) //Move parents down until one is
+  {             //found that comes before the
+    p = (i - 2) / HD + 1; //event.
+    if (!HB(n, Z[p]))
+      break;
+    Z[i] = Z[p];
+    P[Z[i]] = i;
+    i = p;
+  }
+  Z[i] = n; //Drop the event into the hole.
+  P[n] = i;
+}
+
+int siftdown(int i)
+{
+  int n, c, c1, c2, j;
+
+  n = Z[i];
+  for (;;)
+  {
+    c1 = HD * (i - 1) + 2; //Locate the range of children.
+    if (c1 > Zn)
+      break;
+    c2 = c1 + HD - 1;
+    if (c2 > Zn)
+      c2 = Zn;
+
+    for (c = c1, j = c1 + 1; j <= c2; j++) //Find the first child and stop
+      if (HB(Z[j], Z[c]))                  //if it does not come before the
+        c = j;                             //event.
+    if (!HB(Z[c], n))
+      break;
+
+    Z[i] = Z[c]; //Otherwise move the child up and
+    P[Z[i]] = i; //continue from its position.
+    i = c;
+  }
+  Z[i] = n; //Drop the event into the hole.
+  P[n] = i;
+}
+
+/*----------------------------------------------------------------------------*
+4-ARY HEAP: DISPLAY PROFILE
+
+ENTRY: 'label' contains an optional label to be displayed with the results.
+
+EXIT:  The depth of the heap and the number of events at each level have been
+         displayed.
+       'HeapProfile' contains the amount of memory allocated for the heap.
+*/
+
+int HeapProfile(char *label)
+{
+  int d, i, w;
+
+  printf("%s heap of %d events:\n", label, Zn);
+  printf("   Level     Events\n");
+  for (d = 0, i = 1, w = 1; i <= Zn; d++, i += w, w *= HD)
+    printf("%8d %10d\n", d, i + w - 1 <= Zn ? w : Zn - i + 1);
+
+  printf("\n");
+  return Zm * sizeof Z[0];
+}
+
+/*----------------------------------------------------------------------------*
+HEAP: PROVIDE MORE ROOM
+
+ENTRY: 'n' contains the number of elements wanted in 'Z'.
+
+EXIT:  'Z' holds at least 'n' elements, with its contents preserved.
+*/
+
+int hroom(int n)
+{
+  if (n <= Zm)
+    return 0;
+  n = n < 2 * Zm ? 2 * Zm : n; //Grow geometrically.
+  if ((Z = realloc(Z, n * sizeof Z[0])) == 0)
+    Error1(911.6, "n=", n); //Make sure the storage was found.
+  Zm = n;
+}
@@ -0,0 +1,497 @@
+/*----------------------------------------------------------------------------*
+LADDER QUEUE
+
+This backend follows the ladder queue of W. T. Tang, R. S. M. Goh, and I. L.-J.
+Thng (ACM Transactions on Modeling and Computer Simulation 15:175-204, 2005). It
+needs no tuning, and adapts by itself to events crowded into short intervals.
+Scheduled events are held in three tiers:
+
+  Top     An unsorted list of events at or after 'Ltstart', the time beyond
+          which no event has yet been sorted at all. Only the range 'Ltmin' to
+          'Ltmax' of finite times in the list is recorded.
+
+  Ladder  Up to 'LR' rungs of buckets. When the rungs are exhausted, the whole
+          top list is spread across a new first rung, with about one bucket per
+          event. Buckets are taken in order, and any bucket holding more than
+          'LTHRES' events is spread across a new, finer rung beneath the last.
+
+  Bottom  A short sorted list of the events to be dispatched next, filled from
+          one bucket of the lowest rung whenever it becomes empty.
+
+An event is placed in the first tier whose range covers its time, so that each
+event is sorted only once, in a small list, on its way to the bottom. All lists
+are doubly linked with 'P' forward and 'U' backward, and 'K[n]' records the
+list holding each event---the bucket, or 'KTOP' or 'KBOT'---so that an event
+can be cancelled without a search.
+
+Events with infinite times, such as deaths in a population with no mortality,
+stay in the top list and are dispatched only when nothing else remains.
+
+This file is included in 'schedule.c' and shares its arrays 'T', 'P', 'U', and
+'K'.
+*/
+
+#define LR 8                   //Maximum number of rungs.
+#define LTHRES 50              //Largest bucket moved directly to the bottom.
+#define LB 1024                //Most buckets in rungs after the first.
+#define LO0 ((LR - 1) * LB)   //First bucket of the first rung, which
+                               //follows those of the others.
+#define KTOP -2                //Marker in 'K' for events in the top list.
+#define KBOT -3                //Marker in 'K' for events in the bottom list.
+
+static int *Lq; //First event in each bucket, zero if empty.
+static int *Lc; //Number of events in each bucket.
+static int Lm;  //Number of buckets allocated.
+
+static int Lt, Ltn, Lti; //Top list, finite and infinite events held.
+static dec Ltmin, Ltmax; //Range of finite times in the top list.
+static dec Ltstart;      //Earliest time held in the top list.
+static int Lb, Lbn;      //Bottom list and number of events held.
+static struct Sortw Lsw; //Working storage for sorting buckets.
+
+static int Lr;          //Number of rungs in use.
+static int Lo[LR];      //First bucket of each rung within 'Lq'.
+static int Ln[LR];      //Number of buckets in each rung.
+static int Li[LR];      //Current bucket of each rung.
+static dec Ls[LR];      //Starting time of each rung.
+static dec Lw[LR];      //Width of each bucket in each rung.
+
+int LadInit()
+{
+  Lt = Ltn = Lti = 0;
+  Lb = Lbn = 0;
+  Lr = 0;
+  Ltstart = -HUGE_VAL;
+  Ltmin = HUGE_VAL;
+  Ltmax = -HUGE_VAL;
+}
+
+int LadStart(etime t0)
+{
+  return 0; //The ladder is built from the events themselves.
+}
+
+int LadSchedule(int n)
+{
+  int k;
+  etime te;
+
+  te = T[n];
+  k = lplace(te);
+  if (k == KTOP) //Add events beyond all rungs to
+  {              //the top, noting their range.
+    lpush(&Lt, n, KTOP);
+    if (te < TINF)
+    {
+      Ltn += 1;
+      if (te < Ltmin)
+        Ltmin = te;
+      if (te > Ltmax)
+        Ltmax = te;
+    }
+    else
+      Lti += 1;
+  }
+  else if (k == KBOT) //Add anything earlier than all
+  {                   //rungs to the sorted bottom list.
+    lsert(n);
+    Lbn += 1;
+  }
+  else //Otherwise add it to its bucket.
+  {
+    lpush(&Lq[k], n, k);
+    Lc[k] += 1;
+  }
+}
+
+int LadLoad(int h, int c)
+{
+  int j, jn;
+
+  for (j = h; j > 0; j = jn) //Add each event in turn. (Most go
+  {                          //to the unsorted top list.)
+    jn = P[j];
+    LadSchedule(j);
+  }
+}
+
+int LadMove(int n, int m)
+{
+  int k;
+
+  P[n] = P[m];     //Take over the links of the old
+  U[n] = U[m];     //number and point its neighbours,
+  K[n] = k = K[m]; //or the head of its list, at the
+  if (P[n] > 0)    //new number.
+    U[P[n]] = n;
+  if (U[n] > 0)
+    P[U[n]] = n;
+  else if (k == KTOP)
+    Lt = n;
+  else if (k == KBOT)
+    Lb = n;
+  else
+    Lq[k] = n;
+  P[m] = PEMPTY;
+}
+
+int LadReschedule(int n, etime te)
+{
+  int k;
+
+  k = lplace(te);          //If the event stays in the same
+  if (k == K[n] && k >= 0) //bucket only its time changes.
+  {
+    T[n] = te;
+    return 0;
+  }
+
+  LadCancel(n);     //Otherwise remove it and add it
+  T[n] = te;        //again at its new time. (The
+  LadSchedule(n);   //bottom list must stay in order,
+  Es.relisted += 1; //and the top its counts.)
+}
+
+/*----------------------------------------------------------------------------*
+LOCATE LIST FOR A TIME
+
+ENTRY: 'te' contains the time of an event, not earlier than the present.
+
+EXIT:  'lplace' contains the value for 'K' of the list that should hold the
+         event---'KTOP', a bucket on the first rung not yet passed at that
+         time, or 'KBOT'.
+*/
+
+int lplace(etime te)
+{
+  int r, i;
+
+  if (te >= Ltstart)
+    return KTOP;
+
+  for (r = 0; r < Lr; r++) //Find the first rung not yet
+  {                        //passed at the time.
+    i = (te - Ls[r]) / Lw[r];
+    if (i < Li[r])
+      continue;
+    if (i >= Ln[r])
+      i = Ln[r] - 1;  //(Rounding may place an event just
+    return i + Lo[r]; //past the last bucket.)
+  }
+
+  return KBOT;
+}
+
+int LadCancel(int n)
+{
+  int k;
+
+  k = K[n];
+  if (k == KTOP)
+  {
+    lunlink(&Lt, n);
+    if (T[n] < TINF)
+      Ltn -= 1;
+    else
+      Lti -= 1;
+    if (Ltn == 0) //The range of an empty list is
+    {             //reset; otherwise it is left
+      Ltmin = HUGE_VAL; //wide, which does no harm.
+      Ltmax = -HUGE_VAL;
+    }
+  }
+  else if (k == KBOT)
+  {
+    lunlink(&Lb, n);
+    Lbn -= 1;
+  }
+  else
+  {
+    if (k < 0 || k >= Lm || Lc[k] <= 0)
+      Error2(819., "n=", n, " bucket=", k);
+    lunlink(&Lq[k], n);
+    Lc[k] -= 1;
+  }
+  P[n] = PEMPTY;
+}
+
+/*----------------------------------------------------------------------------*
+LADDER QUEUE: LOCATE NEXT EVENT
+
+ENTRY: 'T' contains the time of the next event for every event scheduled.
+
+EXIT:  'LadNext' contains the number of the next event, removed from the
+         ladder. If zero, no events are scheduled.
+
+WORK:  The bottom list is refilled from the ladder, and the ladder from the
+       top, as necessary.
+*/
+
+int LadNext()
+{
+  int n, r, i;
+
+  while (Lb == 0) //Refill the bottom list if it is
+  {               //empty.
+    if (Lr == 0)
+    {
+      if (Ltn == 0) //With no rungs and no finite
+      {             //events in the top, dispatch any
+        if (Lt == 0) //infinite events in turn.
+          return 0;
+        n = Lt;
+        LadCancel(n);
+        return n;
+      }
+      ltop(); //Otherwise start a new ladder.
+      continue;
+    }
+
+    r = Lr - 1; //Advance along the lowest rung to
+    i = Lo[r] + Li[r]; //its next non-empty bucket,
+    while (Li[r] < Ln[r] && Lq[i] == 0) //dropping the rung when it is
+      Li[r] += 1, i += 1;               //exhausted.
+    if (Li[r] >= Ln[r])
+    {
+      Lr -= 1;
+      continue;
+    }
+
+    Li[r] += 1; //Spread a large bucket onto a new
+    if (Lc[i] > LTHRES && Lr < LR) //rung, or move a small one to the
+      lrung(i, Ls[r] + (Li[r] - 1) * Lw[r], Lw[r]); //bottom.
+    else
+      lbottom(i);
+  }
+
+  n = Lb; //Take the first event from the
+  LadCancel(n); //bottom list.
+  return n;
+}
+
+/*----------------------------------------------------------------------------*
+TRANSFER THE TOP
+
+This routine spreads the finite events of the top list across a new first rung,
+with about one bucket per event, and starts the top afresh beyond that rung.
+
+ENTRY: No rungs are in use and the bottom list is empty.
+       The top list holds at least one finite event.
+
+EXIT:  The finite events are on the first rung, or in the bottom list if they
+         all have the same time. Only infinite events remain in the top.
+*/
+
+int ltop()
+{
+  int j, jn, h, nb, i, o;
+  dec w;
+
+  for (h = 0, j = Lt; j > 0; j = jn) //Take the finite events from the
+  {                                  //top list into a single chain.
+    jn = P[j];
+    if (T[j] < TINF)
+    {
+      lunlink(&Lt, j);
+      P[j] = h;
+      h = j;
+    }
+  }
+
+  nb = Ltn + 1;
+  w = (Ltmax - Ltmin) / Ltn;
+  Ltstart = Ltmax; //Events at or after the latest
+  if (w > 0)       //time removed will join the top.
+    Ltstart = Ltmin + nb * w;
+  Ls[0] = Ltmin;
+  Ltn = 0;
+  Ltmin = HUGE_VAL;
+  Ltmax = -HUGE_VAL;
+
+  if (w <= 0) //If all times are equal there is
+  {           //nothing to spread.
+    lchain(h);
+    return 0;
+  }
+
+  lroom(LO0 + nb); //Provide the buckets, after those
+  Lr = 1;          //of the later rungs.
+  o = Lo[0] = LO0;
+  Ln[0] = nb;
+  Li[0] = 0;
+  Lw[0] = w;
+  for (i = o; i < o + nb; i++)
+    Lq[i] = Lc[i] = 0;
+
+  for (j = h; j > 0; j = jn) //Distribute the events.
+  {
+    jn = P[j];
+    i = (T[j] - Ls[0]) / w;
+    if (i >= nb)
+      i = nb - 1;
+    lpush(&Lq[o + i], j, o + i);
+    Lc[o + i] += 1;
+  }
+}
+
+/*----------------------------------------------------------------------------*
+SPAWN A RUNG
+
+ENTRY: 'k' contains a bucket holding more than 'LTHRES' events, which has just
+         been passed on the lowest rung. Fewer than 'LR' rungs are in use.
+       'ts' contains the starting time of the bucket and 'w' its width.
+
+EXIT:  The events of the bucket have been spread across a new, lowest rung.
+*/
+
+int lrung(int k, dec ts, dec w)
+{
+  int j, jn, r, nb, i, o;
+
+  r = Lr++;
+  nb = Lc[k] < LB ? Lc[k] : LB;
+  o = Lo[r] = (r - 1) * LB;
+  Ln[r] = nb;
+  Li[r] = 0;
+  Ls[r] = ts;
+  Lw[r] = w / nb;
+  for (i = o; i < o + nb; i++)
+    Lq[i] = Lc[i] = 0;
+
+  for (j = Lq[k]; j > 0; j = jn) //Move each event from the bucket
+  {                              //into the new rung.
+    jn = P[j];
+    i = (T[j] - ts) / Lw[r];
+    if (i < 0)
+      i = 0;
+    if (i >= nb)
+      i = nb - 1;
+    lpush(&Lq[o + i], j, o + i);
+    Lc[o + i] += 1;
+  }
+  Lq[k] = Lc[k] = 0;
+}
+
+/*----------------------------------------------------------------------------*
+PROVIDE MORE BUCKETS
+
+ENTRY: 'n' contains the number of buckets wanted. No rungs are in use.
+
+EXIT:  'Lq' and 'Lc' hold at least 'n' buckets. Their contents are undefined.
+*/
+
+int lroom(int n)
+{
+  if (n <= Lm)
+    return 0;
+  n = n < 2 * Lm ? 2 * Lm : n; //Grow geometrically.
+  free(Lq);
+  free(Lc);
+  Lq = malloc(n * sizeof Lq[0]);
+  Lc = malloc(n * sizeof Lc[0]);
+  if (Lq == 0 || Lc == 0)
+    Error1(911.7, "n=", n); //Make sure the storage was found.
+  Lm = n;
+}
+
+/*----------------------------------------------------------------------------*
+FILL THE BOTTOM
+
+ENTRY: 'k' contains a non-empty bucket. The bottom list is empty.
+
+EXIT:  The events of the bucket are in the bottom list, sorted by time.
+*/
+
+int lbottom(int k)
+{
+  int h;
+
+  h = Lq[k];
+  Lq[k] = Lc[k] = 0;
+  lchain(h);
+}
+
+int lchain(int h) //Sort a chain linked through 'P'
+{                 //and make it the bottom list.
+  int j, jp;
+
+  Lb = tsort(P, h, &Lsw);
+  for (jp = 0, j = Lb, Lbn = 0; j > 0; jp = j, j = P[j], Lbn++)
+  {
+    U[j] = jp;
+    K[j] = KBOT;
+  }
+  esort(Lbn);
+}
+
+/*----------------------------------------------------------------------------*
+LIST OPERATIONS
+
+'lpush' adds an event to the front of a doubly-linked list and records the list
+in 'K'; 'lunlink' removes an event from a list; 'lsert' places an event in
+order in the bottom list, after any events at the same time.
+*/
+
+int lpush(int *h, int n, int k)
+{
+  P[n] = *h;
+  U[n] = 0;
+  if (*h)
+    U[*h] = n;
+  *h = n;
+  K[n] = k;
+}
+
+int lunlink(int *h, int n)
+{
+  if (P[n] > 0)
+    U[P[n]] = U[n];
+  if (U[n] > 0)
+    P[U[n]] = P[n];
+  else
+    *h = P[n];
+}
+
+int lsert(int n)
+{
+  int j, jp;
+
+  for (jp = 0, j = Lb; j > 0 && T[j] <= T[n]; jp = j, j = P[j])
+    ;
+  P[n] = j;
+  U[n] = jp;
+  if (j > 0)
+    U[j] = n;
+  if (jp > 0)
+    P[jp] = n;
+  else
+    Lb = n;
+  K[n] = KBOT;
+}
+
+/*----------------------------------------------------------------------------*
+LADDER QUEUE: DISPLAY PROFILE
+
+ENTRY: 'label' contains an optional label to be displayed with the results.
+
+EXIT:  The number of events in each tier and on each rung has been displayed.
+       'LadProfile' contains the amount of memory allocated for the buckets.
+*/
+
+int LadProfile(char *label)
+{
+  int r, i, n;
+
+  printf("%s ladder: %d in top (%d infinite), %d in bottom\n",
+         label, Ltn + Lti, Lti, Lbn);
+  printf("   Rung  Buckets    Width     Events\n");
+  for (r = 0; r < Lr; r++)
+  {
+    for (i = Lo[r] + Li[r], n = 0; i < Lo[r] + Ln[r]; i++)
+      n += Lc[i];
+    printf("%7d %8d %8.3g %10d\n", r, Ln[r], Lw[r], n);
+  }
+
+  printf("\n");
+  return Lm * (sizeof Lq[0] + sizeof Lc[0]) + Pn * (sizeof U[0] + sizeof K[0]);
+}
@@ -0,0 +1,167 @@
+/*----------------------------------------------------------------------------*
+SORT EVENTS BY TIME
+
+The backends sort a list of events, linked through 'P', whenever they reach a
+bin or bucket whose order is not known. The general routine 'sort' in 'sort.c'
+serves for any data, but it compares elements through a callback one pair at a
+time and keeps its state in static variables. Events have a simple key---the
+time in 'T'---so this routine gathers the list into an array, with each time
+converted to an unsigned 64-bit integer that orders the same way, and sorts
+that directly.
+
+Short lists, which are the usual case, are sorted by straight insertion. Longer
+lists, such as the crowded bins that follow the loading of the initial
+population or a cohort of births, are sorted by a least-significant-digit radix
+sort, eight bits at a time. The counts for all eight digits are taken in one
+pass over the keys, and any digit that is the same for every key is skipped.
+Since the events of a bin lie close together in time, most of the high-order
+digits are skipped, and a bin is typically sorted in two or three passes.
+
+Both methods are stable, so events with equal times keep the order they had in
+the list, as with 'sort'. The routine keeps no state of its own. Its working
+storage is supplied by the caller in a 'struct Sortw', which grows as needed,
+so that separate schedulers can sort at the same time.
+
+This file is included in 'schedule.c' and shares its array 'T'.
+*/
+
+#define SI 24 //Longest list sorted by insertion.
+
+/*----------------------------------------------------------------------------*
+CONVERT TIME TO KEY
+
+ENTRY: 'te' contains an event time.
+
+EXIT:  'tkey' contains an unsigned integer that is ordered in the same way as
+         the time.
+*/
+
+static unsigned long long tkey(etime te)
+{
+  unsigned long long u;
+
+#if TICKS
+  u = te;                //Offset signed ticks so that
+  return u ^ 1ULL << 63; //they order as unsigned.
+#else
+  memcpy(&u, &te, sizeof u);            //Reverse negative floating
+  return u >> 63 ? ~u : u | 1ULL << 63; //point values and offset
+                                        //positive ones.
+#endif
+}
+
+/*----------------------------------------------------------------------------*
+GROW WORKING STORAGE
+
+ENTRY: 'w' points to working storage for 'tsort'.
+       'n' contains the number of elements it must hold.
+
+EXIT:  'w' holds at least 'n' elements. Its contents are preserved.
+*/
+
+int sortw(struct Sortw *w, int n)
+{
+  int i;
+
+  if (n <= w->n)
+    return 0;
+  n = n < 2 * w->n ? 2 * w->n : n < 256 ? 256 : n; //Grow geometrically.
+
+  for (i = 0; i < 2; i++)
+  {
+    w->x[i] = realloc(w->x[i], n * sizeof *w->x[i]);
+    w->k[i] = realloc(w->k[i], n * sizeof *w->k[i]);
+    if (w->x[i] == 0 || w->k[i] == 0)
+      Error1(911.1, "n=", n); //Make sure the storage was found.
+  }
+  w->n = n;
+}
+
+/*----------------------------------------------------------------------------*
+SORT A LIST OF EVENTS
+
+ENTRY: 'list' points to an array of forward indexes. 'list[0]' is unused.
+       'p' indexes the first element of the list, which ends with a zero.
+       'T' contains the time of each element.
+       'w' points to working storage, initially all zero.
+
+EXIT:  'tsort' indexes the first element in the sorted list, which ends with a
+         zero. Elements with equal times remain in their original order.
+       'w' may have grown to hold the list.
+*/
+
+int tsort(int list[], int p, struct Sortw *w)
+{
+  int i, j, n, d, s, *x, *y, *z;
+  unsigned long long u, *k, *l, *m;
+  int c[8][256];
+
+  if (p == 0 || list[p] == 0)
+    return p; //Return short lists immediately.
+
+  for (n = 0, j = p; j > 0; j = list[j], n++) //Gather the list into the
+  {                                           //working storage, growing
+    if (n >= w->n)                            //it if necessary.
+      sortw(w, n + 1);
+    w->x[0][n] = j;
+    w->k[0][n] = tkey(T[j]);
+  }
+  x = w->x[0];
+  k = w->k[0];
+
+  if (n <= SI)
+  {
+    for (i = 1; i < n; i++) //Sort short lists by insertion.
+    {
+      u = k[i];
+      s = x[i];
+      for (j = i; j > 0 && k[j - 1] > u; j--)
+      {
+        k[j] = k[j - 1];
+        x[j] = x[j - 1];
+      }
+      k[j] = u;
+      x[j] = s;
+    }
+  }
+  else
+  {
+    memset(c, 0, sizeof c); //Count the values of every digit
+    for (i = 0; i < n; i++) //in one pass.
+      for (u = k[i], d = 0; d < 8; d++, u >>= 8)
+        c[d][u & 255]++;
+
+    y = w->x[1];
+    l = w->k[1];
+    for (d = 0; d < 8; d++)
+    {
+      if (c[d][k[0] >> 8 * d & 255] == n)
+        continue; //Skip digits common to all keys.
+
+      for (i = s = 0; i < 256; i++) //Convert the counts to starting
+      {                             //positions and distribute the
+        j = c[d][i];                //keys by this digit.
+        c[d][i] = s;
+        s += j;
+      }
+      for (i = 0; i < n; i++)
+      {
+        j = c[d][k[i] >> 8 * d & 255]++;
+        l[j] = k[i];
+        y[j] = x[i];
+      }
+
+      m = k; //Exchange the arrays, so that the
+      k = l; //keys are always in 'k' and 'x'.
+      l = m;
+      z = x;
+      x = y;
+      y = z;
+    }
+  }
+
+  for (i = 0; i < n - 1; i++) //Link the elements in their
+    list[x[i]] = x[i + 1];    //new order.
+  list[x[n - 1]] = 0;
+  return x[0];
+}
@@ -30,8 +30,8 @@ BirthG(dec w)
     w *= Rand(); //time of next birth.
 
   if (target < t)
-    target = t;               //Schedule an event for a bounded
-  A[PBIRTH].pending = pBirth; //distance in the future.
+    target = t;                 //Schedule an event for a bounded
+  Af(PBIRTH, pending) = pBirth; //distance in the future.
   EventSchedule(BIRTH, target + ypb - w);
 
   target += ypb; //Advance the latest time for the